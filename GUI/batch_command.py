@@ -0,0 +1,101 @@
+"""Reconfigure many robots with one MQTT message on command/broadcast.
+
+    python batch_command.py mode=LINE line_alignTol=20 \
+        --robot esp32_s3_1 line_nodeDist=250 --robot 2 line_nodeDist=300
+
+Fields before the first --robot apply to every robot. Each --robot starts an
+override entry keyed by hostname or numeric ID; a robot that finds its own
+entry applies it on top of the shared fields and skips everyone else's.
+--at-delay MS schedules the batch on the swarm clock (clock_server.py) so
+every robot applies it at the same moment.
+"""
+import argparse
+import json
+import random
+import sys
+import time
+
+import paho.mqtt.client as mqtt
+
+BROADCAST_TOPIC = "command/broadcast"
+
+
+def parse_value(text):
+    try:
+        return int(text)
+    except ValueError:
+        return text
+
+
+def parse_fields(pairs):
+    fields = {}
+    for pair in pairs:
+        key, sep, value = pair.partition("=")
+        if not sep:
+            raise ValueError(f"expected key=value, got {pair!r}")
+        fields[key] = parse_value(value)
+    return fields
+
+
+def build_batch(common, overrides, sid, seq):
+    """One batched command: shared fields plus {robot: {field: value}} overrides."""
+    payload = dict(common)
+    if overrides:
+        payload["robots"] = {str(robot): dict(fields) for robot, fields in overrides.items()}
+    payload["sid"] = sid
+    payload["seq"] = seq
+    return payload
+
+
+def split_args(argv):
+    """Shared key=value pairs, then one list of pairs per --robot."""
+    common, overrides, current = [], {}, None
+    args = iter(argv)
+    for arg in args:
+        if arg == "--robot":
+            current = next(args, None)
+            if current is None:
+                raise ValueError("--robot needs a hostname or ID")
+            overrides.setdefault(current, [])
+        elif current is None:
+            common.append(arg)
+        else:
+            overrides[current].append(arg)
+    return parse_fields(common), {robot: parse_fields(pairs) for robot, pairs in overrides.items()}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--broker", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--dry-run", action="store_true", help="print the payload, don't publish")
+    parser.add_argument("--at-delay", type=int, metavar="MS", help="execute this many ms from now on the swarm clock")
+    args, rest = parser.parse_known_args()
+
+    try:
+        common, overrides = split_args(rest)
+    except ValueError as e:
+        parser.error(str(e))
+
+    if args.at_delay is not None:
+        common["execute_at"] = time.time_ns() // 1_000_000 + args.at_delay
+
+    # Fresh session per invocation, robots only deduplicate within a session
+    payload = json.dumps(build_batch(common, overrides, random.getrandbits(31), 1), separators=(",", ":"))
+    if args.dry_run:
+        print(payload)
+        return 0
+
+    client = mqtt.Client()
+    client.connect(args.broker, args.port)
+    client.loop_start()
+    info = client.publish(BROADCAST_TOPIC, payload, qos=1)
+    info.wait_for_publish()
+    client.loop_stop()
+    client.disconnect()
+    print(f"Sent {len(payload)} bytes to {BROADCAST_TOPIC} ({len(overrides)} robot override(s))")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,74 @@
+"""Compare the binary telemetry frame with the JSON status payload.
+
+Prints bytes per frame and host CPU per encode/decode. Run: python bench_telemetry.py
+The firmware side (buildTelemetryFrame vs buildStatusPayload) is in the
+native_perf suite, see RoboticSwarmSoftware/host/perf/perf_main.cpp.
+"""
+import json
+import timeit
+
+from telemetry import FRAME_SIZE, decode_frame, encode_frame
+
+SAMPLE = {
+    "robot_id": 2,
+    "mode": "POLYGON",
+    "tof_valid_mask": 0x3F,
+    "seq": 123456,
+    "time_ms": 987654,
+    "tof_frame_seq": 49382,
+    "ir_cycle_seq": 1734,
+    "planner_runs": 49000,
+    "planner_saved": 938000,
+    "neighbor_maxDist": 400,
+    "idle_thresh": 150,
+    "line_nodeDist": 200,
+    "line_alignTol": 20,
+    "polygon_radius": 250,
+    "polygon_alignTol": 20,
+    "polygon_sides": 5,
+    "distances": [312, 8190, 1204, 298, 8190, 640],
+    "neighbor_ids": [3, -1, -1, 1, -1, -1],
+    "ir_quality": [255, 12, 0, 240, 3, 40],
+}
+
+
+def json_status(data):
+    # Same shape buildStatusPayload() emits for POLYGON mode
+    return json.dumps({
+        "mode": data["mode"],
+        "neighbor_maxDist": data["neighbor_maxDist"],
+        "polygon_sides": data["polygon_sides"],
+        "polygon_radius": data["polygon_radius"],
+        "polygon_alignTol": data["polygon_alignTol"],
+        "distances": data["distances"],
+        "neighbor_ids": data["neighbor_ids"],
+        "ir_quality": data["ir_quality"],
+        "planner_runs": data["planner_runs"],
+        "planner_saved": data["planner_saved"],
+    }, separators=(",", ":")).encode()
+
+
+def bench(label, fn, number=100000):
+    seconds = min(timeit.repeat(fn, number=number, repeat=5))
+    print(f"  {label:<14} {seconds / number * 1e6:8.2f} us/frame")
+
+
+def main():
+    binary = encode_frame(SAMPLE)
+    text = json_status(SAMPLE)
+    assert decode_frame(binary)["distances"] == SAMPLE["distances"]
+
+    print(f"bytes/frame: binary {FRAME_SIZE}, json {len(text)} "
+          f"(json carries no seq/timestamps)")
+    for hz in (20, 50):
+        print(f"  at {hz} Hz: binary {FRAME_SIZE * hz} B/s, json {len(text) * hz} B/s")
+
+    print("host cpu:")
+    bench("binary encode", lambda: encode_frame(SAMPLE))
+    bench("json encode", lambda: json_status(SAMPLE))
+    bench("binary decode", lambda: decode_frame(binary))
+    bench("json decode", lambda: json.loads(text))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,64 @@
+"""Swarm clock for the robots: answers clock sync requests on clock/+/req.
+
+    python clock_server.py
+
+Keep this running next to the control panel. The swarm clock is this
+machine's Unix time, so commands can be scheduled with
+{"execute_at": <unix ms>} (see swarm_time_ms()) and every synced robot
+applies them at the same moment. Mirrors ClockRequest / ClockResponse in
+RoboticSwarmSoftware/include/clock_sync.hpp.
+"""
+import argparse
+import struct
+import time
+
+import paho.mqtt.client as mqtt
+
+CLOCK_SYNC_VERSION = 1
+REQUEST_FORMAT = struct.Struct("<BBHq")      # version, robot id, request id, t1
+RESPONSE_FORMAT = struct.Struct("<BBHqqq")   # ... t1, t2, t3
+
+
+def swarm_time_us():
+    return time.time_ns() // 1000
+
+
+def swarm_time_ms():
+    return time.time_ns() // 1_000_000
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--broker", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--verbose", action="store_true", help="print every request")
+    args = parser.parse_args()
+
+    def on_connect(client, userdata, flags, rc):
+        client.subscribe("clock/+/req", qos=0)
+        print(f"Answering clock sync requests on {args.broker}:{args.port}")
+
+    def on_message(client, userdata, msg):
+        t2 = swarm_time_us()
+        if len(msg.payload) != REQUEST_FORMAT.size:
+            return
+        version, robot_id, request_id, t1 = REQUEST_FORMAT.unpack(msg.payload)
+        if version != CLOCK_SYNC_VERSION:
+            return
+
+        hostname = msg.topic.split("/")[1]
+        # t3 as late as possible, right before handing the reply to the client
+        reply = RESPONSE_FORMAT.pack(version, robot_id, request_id, t1, t2, swarm_time_us())
+        client.publish(f"clock/{hostname}/resp", reply, qos=0)
+        if args.verbose:
+            print(f"{hostname} request {request_id}")
+
+    client = mqtt.Client()
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(args.broker, args.port)
+    client.loop_forever()
+
+
+if __name__ == "__main__":
+    main()
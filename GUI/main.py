@@ -1,6 +1,7 @@
 import customtkinter as ctk
 import paho.mqtt.client as mqtt
 import json
+import random
 import time
 from datetime import datetime
 from robot_hostnames import robots
@@ -10,6 +11,21 @@ MQTT_BROKER = "localhost"
 MQTT_PORT = 1883
 ROBOT_HOSTNAMES = robots  # Import from robot_hostnames.py
 
+# Command numbering: robots drop repeats of a (sid, seq) pair, so QoS 1
+# redeliveries apply once while identical commands sent twice both run
+COMMAND_SESSION_ID = random.getrandbits(31)
+command_seq = 0
+
+def next_command_ids():
+    global command_seq
+    command_seq += 1
+    return {"sid": COMMAND_SESSION_ID, "seq": command_seq}
+
+# Synchronized mode changes: robots hold the command until this far in the
+# future on the swarm clock (needs clock_server.py running), long enough
+# for the broker to reach every robot
+SYNC_START_DELAY_MS = 500
+
 # ---------- Appearance ----------
 ctk.set_appearance_mode("System")
 ctk.set_default_color_theme("blue")
@@ -225,6 +241,10 @@ def send_move_command():
     if back_entry.get():
         payload["b"] = int(back_entry.get())
     
+    # Same swarm time for every robot, so the formation starts in step
+    if sync_start_checkbox.get():
+        payload["execute_at"] = time.time_ns() // 1_000_000 + SYNC_START_DELAY_MS
+    
     # Publish command
     target_robots = get_target_robots()
     success_count = 0
@@ -236,7 +256,7 @@ def send_move_command():
         topic = "command/broadcast" if broadcast_checkbox.get() else f"command/individual/{base_hostname}"
         
         try:
-            result = mqtt_client.publish(topic, json.dumps(payload), qos=1)
+            result = mqtt_client.publish(topic, json.dumps({**payload, **next_command_ids()}), qos=1)
             if result.rc == mqtt.MQTT_ERR_SUCCESS:
                 success_count += 1
                 print(f"Sent move command to {topic}")
@@ -267,6 +287,12 @@ ctk.CTkLabel(state_frame, text="IDLE Mode", font=ctk.CTkFont(size=11, weight="bo
 idle_thresh_entry = ctk.CTkEntry(state_frame, placeholder_text="Idle Threshold", width=150)
 idle_thresh_entry.grid(row=2, column=0, pady=2, padx=5)
 
+# ToF ranging profile, only sent when one is picked
+TOF_PROFILE_UNCHANGED = "ToF profile: unchanged"
+tof_profile_dropdown = ctk.CTkOptionMenu(state_frame, values=[TOF_PROFILE_UNCHANGED, "auto", "high_speed", "default", "long_range"], width=150)
+tof_profile_dropdown.grid(row=4, column=0, pady=2, padx=5)
+tof_profile_dropdown.set(TOF_PROFILE_UNCHANGED)
+
 # LINE
 ctk.CTkLabel(state_frame, text="LINE Mode", font=ctk.CTkFont(size=11, weight="bold")).grid(row=1, column=1, pady=(0, 5))
 line_dist_entry = ctk.CTkEntry(state_frame, placeholder_text="Line Distance", width=150)
@@ -276,7 +302,7 @@ line_alignTol_entry.grid(row=3, column=1, pady=2, padx=5)
 
 # POLYGON
 ctk.CTkLabel(state_frame, text="POLYGON Mode", font=ctk.CTkFont(size=11, weight="bold")).grid(row=1, column=2, pady=(0, 5))
-polygon_radius_entry = ctk.CTkEntry(state_frame, placeholder_text="Polygon Radius", width=150)
+polygon_radius_entry = ctk.CTkEntry(state_frame, placeholder_text="Polygon Side (mm)", width=150)
 polygon_radius_entry.grid(row=2, column=2, pady=2, padx=5)
 polygon_sides_entry = ctk.CTkEntry(state_frame, placeholder_text="Polygon Sides", width=150)
 polygon_sides_entry.grid(row=3, column=2, pady=2, padx=5)
@@ -287,6 +313,10 @@ polygon_alignTol_entry.grid(row=4, column=2, pady=2, padx=5)
 ctk.CTkLabel(state_frame, text="General", font=ctk.CTkFont(size=11, weight="bold")).grid(row=1, column=3, pady=(0, 5))
 neighbor_maxDist_entry = ctk.CTkEntry(state_frame, placeholder_text="Neighbor Max Dist", width=150)
 neighbor_maxDist_entry.grid(row=2, column=3, pady=2, padx=5)
+telemetry_hz_entry = ctk.CTkEntry(state_frame, placeholder_text="Binary Telemetry Hz", width=150)
+telemetry_hz_entry.grid(row=3, column=3, pady=2, padx=5)
+peer_hz_entry = ctk.CTkEntry(state_frame, placeholder_text="Peer UDP Hz", width=150)
+peer_hz_entry.grid(row=4, column=3, pady=2, padx=5)
 
 # Mode dropdown and button
 state_dropdown = ctk.CTkOptionMenu(state_frame, values=["OFF", "IDLE", "LINE", "POLYGON", "MANUAL"], width=200)
@@ -295,8 +325,11 @@ state_dropdown.set("OFF")
 
 ctk.CTkButton(state_frame, text="Send Update", command=lambda: send_update_state(), width=200).grid(row=5, column=2, columnspan=2, pady=(10, 5), padx=5, sticky="ew")
 
+sync_start_checkbox = ctk.CTkCheckBox(state_frame, text=f"Synchronized start (+{SYNC_START_DELAY_MS} ms, needs clock_server.py)")
+sync_start_checkbox.grid(row=6, column=0, columnspan=4, pady=(0, 5), padx=5, sticky="w")
+
 update_status_label = ctk.CTkLabel(state_frame, text="")
-update_status_label.grid(row=6, column=0, columnspan=4, pady=(0, 10))
+update_status_label.grid(row=7, column=0, columnspan=4, pady=(0, 10))
 
 # ---------- Helper Functions ----------
 def get_target_robots():
@@ -312,6 +345,12 @@ def send_update_state():
     # General
     if neighbor_maxDist_entry.get():
         payload["neighbor_maxDist"] = int(neighbor_maxDist_entry.get())
+    if telemetry_hz_entry.get():
+        payload["telemetry_hz"] = int(telemetry_hz_entry.get())
+    if peer_hz_entry.get():
+        payload["peer_hz"] = int(peer_hz_entry.get())
+    if tof_profile_dropdown.get() != TOF_PROFILE_UNCHANGED:
+        payload["tof_profile"] = tof_profile_dropdown.get()
     
     # IDLE
     if state == "IDLE" and idle_thresh_entry.get():
@@ -333,6 +372,10 @@ def send_update_state():
         if polygon_alignTol_entry.get():
             payload["polygon_alignTol"] = int(polygon_alignTol_entry.get())
     
+    # Same swarm time for every robot, so the formation starts in step
+    if sync_start_checkbox.get():
+        payload["execute_at"] = time.time_ns() // 1_000_000 + SYNC_START_DELAY_MS
+    
     # Publish command
     target_robots = get_target_robots()
     success_count = 0
@@ -344,7 +387,7 @@ def send_update_state():
         topic = "command/broadcast" if broadcast_checkbox.get() else f"command/individual/{base_hostname}"
         
         try:
-            result = mqtt_client.publish(topic, json.dumps(payload), qos=1)
+            result = mqtt_client.publish(topic, json.dumps({**payload, **next_command_ids()}), qos=1)
             if result.rc == mqtt.MQTT_ERR_SUCCESS:
                 success_count += 1
                 print(f"Sent update to {topic}: {payload}")
@@ -0,0 +1,139 @@
+"""Fetch a robot's flight recorder over MQTT and write it as CSV.
+
+    python recorder_dump.py esp32_s3_2 dump.csv            # freeze now and dump
+    python recorder_dump.py esp32_s3_2 dump.csv --no-request   # wait for a dump someone else asked for
+
+Mirrors FlightRecord / RecorderChunkHeader in
+RoboticSwarmSoftware/include/flight_recorder.hpp.
+Send {"recorder": "arm"} afterwards to start recording again.
+"""
+import argparse
+import csv
+import json
+import struct
+import sys
+import threading
+
+import paho.mqtt.client as mqtt
+
+RECORDER_VERSION = 1
+HEADER = struct.Struct("<BBHHHI")
+RECORD = struct.Struct("<IBB7h")
+
+RECORD_TYPES = {
+    0: "empty",
+    1: "tof_frame",
+    2: "decision_sensor",
+    3: "decision_bearing",
+    4: "motor_target",
+    5: "trigger",
+}
+MODES = ["OFF", "IDLE", "LINE", "POLYGON", "MANUAL"]
+CSV_COLUMNS = ["time_us", "event", "mode", "valid_mask", "result",
+               "d0", "d1", "d2", "d3", "d4", "d5", "tof_seq",
+               "left", "right", "back", "trigger_source"]
+
+
+def parse_chunk(payload):
+    """Returns (header dict, list of record tuples) for one dump message."""
+    version, record_size, index, count, records, dump_id = HEADER.unpack_from(payload)
+    if version != RECORDER_VERSION or record_size != RECORD.size:
+        raise ValueError(f"unsupported recorder chunk v{version} with {record_size} byte records")
+    body = payload[HEADER.size:HEADER.size + records * RECORD.size]
+    return ({"index": index, "count": count, "dump_id": dump_id},
+            [RECORD.unpack_from(body, i * RECORD.size) for i in range(records)])
+
+
+def record_to_row(record):
+    time_us, rtype, arg, *data = record
+    row = {"time_us": time_us, "event": RECORD_TYPES.get(rtype, f"type{rtype}")}
+    if rtype == 1:
+        row["valid_mask"] = f"0x{arg:02x}"
+        row.update({f"d{i}": data[i] for i in range(6)})
+        row["tof_seq"] = data[6] & 0xFFFF
+    elif rtype in (2, 3):
+        row["mode"] = MODES[arg] if arg < len(MODES) else arg
+        row["result"] = data[0]
+    elif rtype == 4:
+        row["left"], row["right"], row["back"] = data[0], data[1], data[2]
+    elif rtype == 5:
+        row["trigger_source"] = arg
+    return row
+
+
+def write_csv(records, path):
+    # Timestamps are micros() and wrap after ~71 minutes, unwrap relative to the first
+    rows = []
+    offset = 0
+    previous = None
+    for record in records:
+        if record[1] == 0:
+            continue
+        row = record_to_row(record)
+        if previous is not None and row["time_us"] + offset < previous - 2**31:
+            offset += 2**32
+        row["time_us"] += offset
+        previous = row["time_us"]
+        rows.append(row)
+
+    with open(path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=CSV_COLUMNS)
+        writer.writeheader()
+        writer.writerows(rows)
+    return len(rows)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("hostname", help="robot hostname, e.g. esp32_s3_2")
+    parser.add_argument("csv", help="output CSV path")
+    parser.add_argument("--broker", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--timeout", type=float, default=30.0, help="seconds to wait for the whole dump")
+    parser.add_argument("--no-request", action="store_true", help="don't send the dump command")
+    args = parser.parse_args()
+
+    hostname = args.hostname.replace(".local", "")
+    chunks = {}
+    state = {"dump_id": None, "count": None}
+    done = threading.Event()
+
+    def on_connect(client, userdata, flags, rc):
+        client.subscribe(f"telemetry/{hostname}/recorder")
+        if not args.no_request:
+            client.publish(f"command/individual/{hostname}", json.dumps({"recorder": "dump"}), qos=1)
+
+    def on_message(client, userdata, msg):
+        header, records = parse_chunk(msg.payload)
+        if state["dump_id"] != header["dump_id"]:
+            # A newer dump started, forget the partial one
+            state["dump_id"], state["count"] = header["dump_id"], header["count"]
+            chunks.clear()
+        chunks[header["index"]] = records
+        print(f"\rchunk {len(chunks)}/{header['count']}", end="", flush=True)
+        if len(chunks) == state["count"]:
+            done.set()
+
+    client = mqtt.Client()
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(args.broker, args.port, 60)
+    client.loop_start()
+    complete = done.wait(args.timeout)
+    client.loop_stop()
+    client.disconnect()
+    print()
+
+    if not chunks:
+        print("no recorder data received", file=sys.stderr)
+        return 1
+    if not complete:
+        print(f"dump incomplete, writing {len(chunks)}/{state['count']} chunks", file=sys.stderr)
+
+    records = [r for index in sorted(chunks) for r in chunks[index]]
+    print(f"wrote {write_csv(records, args.csv)} records to {args.csv}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
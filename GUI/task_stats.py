@@ -0,0 +1,79 @@
+"""Print per-task latency and stack reports from telemetry/<hostname>/stats.
+
+    python task_stats.py esp32_s3_2
+
+Each report is cumulative since boot; this prints the difference between
+consecutive reports so every line covers the last interval (5 s).
+"""
+import argparse
+import json
+
+import paho.mqtt.client as mqtt
+
+
+def histogram_percentile(buckets, fraction):
+    """Upper edge (cycles) of the log2 bucket holding the given fraction of samples."""
+    total = sum(buckets.values())
+    if total == 0:
+        return 0
+    seen = 0
+    for b in sorted(buckets):
+        seen += buckets[b]
+        if seen >= fraction * total:
+            return 2 ** (b + 1)
+    return 2 ** (max(buckets) + 1)
+
+
+def expand(probe):
+    return {probe["b0"] + i: n for i, n in enumerate(probe.get("hist", []))}
+
+
+def print_report(report, previous):
+    mhz = report.get("cpu_mhz", 240)
+    print(f"--- uptime {report['uptime_ms'] / 1000:.1f} s")
+    print(f"  {'probe':<16}{'n':>8}{'p50 us':>10}{'p99 us':>10}{'max us':>10}")
+    for name, probe in report["probes"].items():
+        buckets = expand(probe)
+        count = probe["n"]
+        if previous and name in previous["probes"]:
+            old = expand(previous["probes"][name])
+            buckets = {b: n - old.get(b, 0) for b, n in buckets.items()}
+            count -= previous["probes"][name]["n"]
+        # Bucket edges overshoot by up to 2x, never report past the observed max
+        p50 = min(histogram_percentile(buckets, 0.50), probe["max"]) / mhz
+        p99 = min(histogram_percentile(buckets, 0.99), probe["max"]) / mhz
+        print(f"  {name:<16}{count:>8}{p50:>10.1f}{p99:>10.1f}{probe['max'] / mhz:>10.1f}")
+    for name, task in report.get("stack", {}).items():
+        print(f"  stack {name:<16} {task['min_free']:>6} of {task['size']} bytes never used")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("hostname")
+    parser.add_argument("--broker", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    args = parser.parse_args()
+
+    hostname = args.hostname.replace(".local", "")
+    state = {"previous": None}
+
+    def on_connect(client, userdata, flags, rc):
+        client.subscribe(f"telemetry/{hostname}/stats")
+
+    def on_message(client, userdata, msg):
+        report = json.loads(msg.payload.decode())
+        previous = state["previous"]
+        if previous and report["uptime_ms"] < previous["uptime_ms"]:
+            previous = None  # Robot rebooted
+        print_report(report, previous)
+        state["previous"] = report
+
+    client = mqtt.Client()
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(args.broker, args.port, 60)
+    client.loop_forever()
+
+
+if __name__ == "__main__":
+    main()
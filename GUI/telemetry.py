@@ -0,0 +1,78 @@
+"""Decoder for the robots' binary telemetry (telemetry/<hostname>/bin).
+
+Mirrors TelemetryFrame in RoboticSwarmSoftware/include/telemetry_frame.hpp.
+Enable it per robot with a {"telemetry_hz": 1..50} command, 0 turns it off.
+"""
+import struct
+
+TELEMETRY_VERSION = 2
+NO_NEIGHBOR = 0xFF  # neighbor_ids byte for "none", -1 in the decoded dict
+
+# Little-endian, packed, same field order as the C++ struct
+FRAME_FORMAT = struct.Struct("<BBBB6I6HBB6H6B6B")
+FRAME_SIZE = FRAME_FORMAT.size  # 66 bytes
+
+MODES = ["OFF", "IDLE", "LINE", "POLYGON", "MANUAL"]
+
+
+def decode_frame(payload):
+    """Decode one binary telemetry payload into a dict shaped like the JSON status.
+
+    Raises ValueError for a wrong size or an unknown version.
+    """
+    if len(payload) != FRAME_SIZE:
+        raise ValueError(f"telemetry frame is {len(payload)} bytes, expected {FRAME_SIZE}")
+
+    f = FRAME_FORMAT.unpack(payload)
+    if f[0] != TELEMETRY_VERSION:
+        raise ValueError(f"unsupported telemetry version {f[0]}")
+
+    mode = f[2]
+    return {
+        "version": f[0],
+        "robot_id": f[1],
+        "mode": MODES[mode] if mode < len(MODES) else "UNKNOWN",
+        "tof_valid_mask": f[3],
+        "seq": f[4],
+        "time_ms": f[5],
+        "tof_frame_seq": f[6],
+        "ir_cycle_seq": f[7],
+        "planner_runs": f[8],
+        "planner_saved": f[9],
+        "neighbor_maxDist": f[10],
+        "idle_thresh": f[11],
+        "line_nodeDist": f[12],
+        "line_alignTol": f[13],
+        "polygon_radius": f[14],
+        "polygon_alignTol": f[15],
+        "polygon_sides": f[16],
+        "distances": list(f[18:24]),
+        "neighbor_ids": [-1 if n == NO_NEIGHBOR else n for n in f[24:30]],
+        "ir_quality": list(f[30:36]),
+    }
+
+
+def encode_frame(data):
+    """Inverse of decode_frame, for tests and the benchmark."""
+    return FRAME_FORMAT.pack(
+        TELEMETRY_VERSION, data["robot_id"], MODES.index(data["mode"]), data["tof_valid_mask"],
+        data["seq"], data["time_ms"], data["tof_frame_seq"], data["ir_cycle_seq"],
+        data["planner_runs"], data["planner_saved"],
+        data["neighbor_maxDist"], data["idle_thresh"], data["line_nodeDist"], data["line_alignTol"],
+        data["polygon_radius"], data["polygon_alignTol"], data["polygon_sides"], 0,
+        *data["distances"], *[NO_NEIGHBOR if n < 0 else n for n in data["neighbor_ids"]], *data["ir_quality"])
+
+
+class SequenceTracker:
+    """Counts frames lost between consecutive telemetry seq numbers."""
+
+    def __init__(self):
+        self.last_seq = None
+        self.received = 0
+        self.lost = 0
+
+    def update(self, seq):
+        if self.last_seq is not None and seq > self.last_seq:
+            self.lost += seq - self.last_seq - 1
+        self.last_seq = seq
+        self.received += 1
@@ -0,0 +1,152 @@
+// Host benchmark: MQTT command ingest, the old String-based mqttCallback path
+// against parseCommand() + replay window. Reports time and heap churn per command.
+//   pio run -e native_bench && .pio/build/native_bench/program
+
+#include <chrono>
+#include <cstdio>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <ArduinoJson.h>
+#include "command_ingest.hpp"
+
+static const char* HOSTNAME = "esp32_s3_2";
+static const int COMMANDS = 20000;
+
+//-------------------------
+// Heap accounting
+//-------------------------
+static size_t heapAllocs = 0;
+static size_t heapBytes = 0;
+
+void* operator new(size_t size) {
+    heapAllocs++;
+    heapBytes += size;
+    void* p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ArduinoJson's default allocator is plain malloc, count it the same way
+struct CountingHeap : ArduinoJson::Allocator {
+    void* allocate(size_t size) override {
+        heapAllocs++;
+        heapBytes += size;
+        return malloc(size);
+    }
+    void deallocate(void* ptr) override { free(ptr); }
+    void* reallocate(void* ptr, size_t newSize) override {
+        heapAllocs++;
+        heapBytes += newSize;
+        return realloc(ptr, newSize);
+    }
+};
+static CountingHeap countingHeap;
+
+static volatile uint32_t sink; // Keeps the parsed fields alive
+
+//-------------------------
+// Old path, std::string standing in for Arduino String
+//-------------------------
+static std::string lastReceivedMessage = "";
+
+static bool ingestOld(const char* topic, const uint8_t* payload, unsigned int length) {
+    std::string message = "";
+    for (unsigned int i = 0; i < length; i++) {
+        message += (char)payload[i];
+    }
+
+    std::string topicStr = std::string(topic);
+    std::string hostStr = HOSTNAME;
+    bool isBroadcast = topicStr == "command/broadcast";
+    bool isMyCommand = topicStr.compare(0, 19, "command/individual/") == 0 &&
+                       topicStr.size() >= hostStr.size() &&
+                       topicStr.compare(topicStr.size() - hostStr.size(), hostStr.size(), hostStr) == 0;
+    if (!isBroadcast && !isMyCommand) return false;
+
+    if (message == lastReceivedMessage) return false;
+    lastReceivedMessage = message;
+
+    JsonDocument doc(&countingHeap);
+    if (deserializeJson(doc, message)) return false;
+
+    const char* mode = doc["mode"] | "";
+    sink = strlen(mode) + doc["neighbor_maxDist"].as<uint16_t>() + doc["polygon_sides"].as<uint8_t>() +
+           doc["polygon_radius"].as<uint16_t>() + (doc["l"] | 0) + (doc["r"] | 0) + (doc["b"] | 0);
+    return true;
+}
+
+//-------------------------
+// New path
+//-------------------------
+static ReplayWindow replayWindow = {};
+
+static bool ingestNew(const char* topic, const uint8_t* payload, unsigned int length) {
+    if (matchCommandTopic(topic, HOSTNAME) == TOPIC_OTHER) return false;
+
+    ParsedCommand cmd;
+    if (parseCommand(payload, length, &cmd)) return false;
+    if (cmd.hasSeq && !replayWindowAccept(&replayWindow, cmd.session, cmd.seq)) return false;
+
+    sink = cmd.mode + cmd.neighborMaxDist + cmd.polygonSides + cmd.polygonRadius + cmd.l + cmd.r + cmd.b;
+    return true;
+}
+
+//-------------------------
+// Driver
+//-------------------------
+typedef bool (*IngestFn)(const char*, const uint8_t*, unsigned int);
+
+static void run(const char* label, IngestFn ingest, const std::vector<std::string>& topics,
+                const std::vector<std::string>& payloads) {
+    size_t allocsBefore = heapAllocs;
+    size_t bytesBefore = heapBytes;
+    int accepted = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < payloads.size(); i++) {
+        accepted += ingest(topics[i].c_str(), (const uint8_t*)payloads[i].data(), payloads[i].size());
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double n = (double)payloads.size();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("  %-6s %8.0f ns/cmd  %6.2f allocs/cmd  %7.1f heap B/cmd  accepted %d/%d\n", label, ns / n,
+           (heapAllocs - allocsBefore) / n, (heapBytes - bytesBefore) / n, accepted, (int)payloads.size());
+}
+
+int main() {
+    std::vector<std::string> topics;
+    std::vector<std::string> payloads;
+    char buffer[256];
+
+    // Mix of what the GUI sends: mode changes, polygon updates, manual moves
+    for (int i = 0; i < COMMANDS; i++) {
+        switch (i % 3) {
+            case 0:
+                snprintf(buffer, sizeof(buffer), "{\"mode\": \"LINE\", \"neighbor_maxDist\": 400, \"line_nodeDist\": 200, "
+                         "\"line_alignTol\": 20, \"sid\": 12345, \"seq\": %d}", i);
+                break;
+            case 1:
+                snprintf(buffer, sizeof(buffer), "{\"mode\": \"POLYGON\", \"polygon_radius\": 250, \"polygon_sides\": 5, "
+                         "\"polygon_alignTol\": 20, \"sid\": 12345, \"seq\": %d}", i);
+                break;
+            default:
+                snprintf(buffer, sizeof(buffer), "{\"mode\": \"MANUAL\", \"l\": 200, \"r\": -200, \"b\": 0, "
+                         "\"sid\": 12345, \"seq\": %d}", i);
+                break;
+        }
+        topics.push_back((i % 2) ? "command/broadcast" : "command/individual/esp32_s3_2");
+        payloads.push_back(buffer);
+    }
+
+    printf("MQTT command ingest, %d commands\n", COMMANDS);
+    run("old", ingestOld, topics, payloads);
+    run("new", ingestNew, topics, payloads);
+    printf("  arena high water %u of %u bytes, %u allocation failures\n", (unsigned)commandArena().highWater(),
+           (unsigned)COMMAND_ARENA_BYTES, (unsigned)commandArena().failures());
+    return 0;
+}
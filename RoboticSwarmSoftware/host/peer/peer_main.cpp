@@ -0,0 +1,225 @@
+// Loopback test bench for the UDP peer link: several emulated robots on one
+// Linux box, each with its own multicast socket on 127.0.0.1, running the
+// same packet and table code as the firmware (peer_link.cpp).
+//   pio run -e native_peer && .pio/build/native_peer/program [options]
+//     --nodes N       emulated robots in this process (default 4)
+//     --seconds S     run time (default 6)
+//     --hz HZ         send rate per node (default PEER_DEFAULT_HZ)
+//     --loss PCT      drop this share of received packets (default 0)
+//     --stop ID       node ID goes silent halfway, must age out everywhere
+//     --node ID       run a single node with this ID until killed, printing
+//                     its table every second (start several in separate shells)
+// Exits 1 if a node's table does not match who is actually alive.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "peer_link.hpp"
+#include "motor_module.hpp"
+
+struct NodeOptions {
+    uint8_t id;
+    uint8_t hz;
+    uint32_t runMs;         // 0 = forever
+    uint32_t silentAfterMs; // 0 = never
+    uint32_t lossPct;
+    bool print;
+};
+
+struct NodeResult {
+    PeerFrame table;
+    uint32_t sent;
+    uint32_t received;
+    uint32_t dropped;
+};
+
+static std::atomic<bool> setupFailed(false);
+
+static int openPeerSocket() {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)); // Every node binds the same port
+
+    sockaddr_in bindAddr = {};
+    bindAddr.sin_family = AF_INET;
+    bindAddr.sin_port = htons(PEER_PORT);
+    bindAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (sockaddr*)&bindAddr, sizeof(bindAddr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Join and send on loopback so the test never leaves the machine
+    const uint8_t group[4] = {PEER_GROUP_IP};
+    ip_mreq membership = {};
+    memcpy(&membership.imr_multiaddr, group, 4);
+    membership.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+    in_addr loopback;
+    loopback.s_addr = htonl(INADDR_LOOPBACK);
+    uint8_t loop = 1;
+    if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback)) < 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Made-up but plausible robot state, drifting so receivers see it change
+static void fakeState(State* state, uint8_t id, uint32_t nowMs) {
+    state->mode = Config::POLYGON;
+    state->tof_validMask = 0x3F;
+    for (int i = 0; i < 6; i++) {
+        state->distances[i] = 200 + id * 10 + i * 50 + (nowMs / 100) % 40;
+    }
+}
+
+static void printTable(uint8_t id, const PeerFrame& table, uint32_t nowMs) {
+    printf("node %u hears %u peer(s):", id, table.count);
+    for (uint8_t i = 0; i < table.count; i++) {
+        const PeerEntry& e = table.peers[i];
+        printf("  [%u role %u d0 %u lost %u age %ums]", e.robotId, e.role, e.distances[0], e.lost,
+               (unsigned)(nowMs - e.lastHeardMs));
+    }
+    printf("\n");
+}
+
+static void runNode(NodeOptions opt, NodeResult* result) {
+    memset(result, 0, sizeof(*result));
+    int fd = openPeerSocket();
+    if (fd < 0) {
+        perror("peer socket");
+        setupFailed = true;
+        return;
+    }
+
+    sockaddr_in groupAddr = {};
+    const uint8_t group[4] = {PEER_GROUP_IP};
+    groupAddr.sin_family = AF_INET;
+    groupAddr.sin_port = htons(PEER_PORT);
+    memcpy(&groupAddr.sin_addr, group, 4);
+
+    std::mt19937 rng(opt.id);
+    State state = State();
+    uint16_t seq = 0;
+    uint32_t start = millis();
+    uint32_t lastSend = 0, lastPrint = 0;
+    bool first = true;
+
+    while (opt.runMs == 0 || millis() - start < opt.runMs) {
+        uint32_t now = millis();
+        bool silent = opt.silentAfterMs && now - start >= opt.silentAfterMs;
+
+        if (!silent && (first || now - lastSend >= 1000u / opt.hz)) {
+            PeerPacket packet;
+            fakeState(&state, opt.id, now);
+            buildPeerPacket(&packet, state, opt.id, ROLE_MOVING, opt.hz, seq++);
+            sendto(fd, &packet, sizeof(packet), 0, (sockaddr*)&groupAddr, sizeof(groupAddr));
+            result->sent++;
+            lastSend = now;
+            first = false;
+        }
+
+        // Same shape as receivePeerStates() in network_module.cpp
+        pollfd pfd = {fd, POLLIN, 0};
+        poll(&pfd, 1, 5);
+        uint8_t buffer[sizeof(PeerPacket) + 1];
+        ssize_t length;
+        while ((length = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+            PeerPacket packet;
+            if (silent || !parsePeerPacket(buffer, length, &packet) || packet.robotId == opt.id) continue;
+            if (rng() % 100 < opt.lossPct) {
+                result->dropped++;
+                continue;
+            }
+            peerTableUpdate(&result->table, packet, millis());
+            result->received++;
+        }
+        peerTableAge(&result->table, millis());
+
+        if (opt.print && now - lastPrint >= 1000) {
+            printTable(opt.id, result->table, now);
+            lastPrint = now;
+        }
+    }
+    close(fd);
+}
+
+int main(int argc, char** argv) {
+    int nodes = 4;
+    uint32_t seconds = 6;
+    uint8_t hz = PEER_DEFAULT_HZ;
+    uint32_t lossPct = 0;
+    int stopId = 0;
+    int singleId = 0;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--nodes") && hasValue) nodes = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && hasValue) seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--hz") && hasValue) hz = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--loss") && hasValue) lossPct = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--stop") && hasValue) stopId = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--node") && hasValue) singleId = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "unknown option %s (see the header of peer_main.cpp)\n", argv[i]);
+            return 2;
+        }
+    }
+
+    hz = constrain(hz, 1, PEER_MAX_HZ);
+
+    if (singleId > 0) {
+        NodeResult result;
+        runNode(NodeOptions{(uint8_t)singleId, hz, 0, 0, lossPct, true}, &result);
+        return 1; // Only returns if the socket could not be opened
+    }
+
+    nodes = constrain(nodes, 2, 250);
+    uint32_t runMs = seconds * 1000;
+    std::vector<NodeResult> results(nodes);
+    std::vector<std::thread> threads;
+    for (int n = 0; n < nodes; n++) {
+        uint8_t id = n + 1;
+        NodeOptions opt = {id, hz, runMs, (id == stopId) ? runMs / 2 : 0, lossPct, false};
+        threads.push_back(std::thread(runNode, opt, &results[n]));
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    if (setupFailed) return 2;
+
+    // Everyone alive at the end should hear every other live node, up to the table size
+    int failures = 0;
+    uint32_t now = millis();
+    for (int n = 0; n < nodes; n++) {
+        uint8_t id = n + 1;
+        const NodeResult& r = results[n];
+        uint32_t lost = 0;
+        for (uint8_t i = 0; i < r.table.count; i++) lost += r.table.peers[i].lost;
+        printf("node %3u  sent %5u  received %6u  loss-dropped %5u  seq-gaps %4u  ", id, r.sent, r.received,
+               r.dropped, lost);
+        printTable(id, r.table, now);
+
+        if (id == stopId) continue;
+        int expected = min(nodes - 1 - (stopId > 0 && stopId <= nodes ? 1 : 0), PEER_TABLE_SIZE);
+        bool stopSeen = stopId && peerTableFind(r.table, stopId);
+        if (r.table.count != expected || stopSeen) {
+            printf("  FAIL node %u: %u peers, expected %d%s\n", id, r.table.count, expected,
+                   stopSeen ? ", silent node not aged out" : "");
+            failures++;
+        }
+    }
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
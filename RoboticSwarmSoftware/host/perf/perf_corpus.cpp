@@ -0,0 +1,131 @@
+#include "perf_corpus.hpp"
+#include "../sim/swarm_sim.hpp"
+#include "motor_module.hpp"
+
+static uint32_t nextRandom(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+//-------------------------
+// Formation states
+//-------------------------
+std::vector<State> corpusFormationStates(Config::Mode mode, uint32_t seed) {
+    SimScenario scenario = SimScenario();
+    scenario.name = "corpus";
+    scenario.mode = mode;
+    scenario.arenaMm = 3000;
+    scenario.config.neighbor_maxDist = 800;
+    scenario.config.idle_thresh = 300;
+    scenario.config.line_nodeDist = 300;
+    scenario.config.line_alignTol = 30;
+    scenario.config.polygon_radius = 300;
+    scenario.config.polygon_alignTol = 30;
+
+    switch (mode) {
+        case Config::IDLE:    scenario.robots = 12; scenario.spawnRadiusMm = 500; scenario.config.polygon_sides = 3; break;
+        case Config::LINE:    scenario.robots = 4;  scenario.spawnRadiusMm = 500; scenario.config.polygon_sides = 3; break;
+        default:              scenario.robots = 5;  scenario.spawnRadiusMm = 450; scenario.config.polygon_sides = 5; break;
+    }
+
+    std::vector<SimRobot> robots;
+    simInitRobots(robots, scenario, seed);
+
+    // Run the swarm and keep every ToF frame until there are enough
+    std::vector<State> states;
+    uint32_t rng = seed * 2654435761u + 1;
+    for (uint32_t nowMs = 0; states.size() < PERF_STATE_SAMPLES; nowMs += SIM_TICK_MS) {
+        for (size_t i = 0; i < robots.size(); i++) {
+            if ((nowMs + robots[i].framePhaseMs) % SIM_TOF_PERIOD_MS == 0) {
+                simSense(robots[i], robots, scenario.arenaMm, &rng);
+                states.push_back(robots[i].state);
+            }
+        }
+        for (size_t i = 0; i < robots.size(); i++) {
+            simCurrentRobot = &robots[i];
+            if (robots[i].frameFresh) {
+                handleMotors(&robots[i].state, SIM_STEPS_TO_SCOOT, &robots[i].polarMap);
+                robots[i].frameFresh = false;
+            }
+            simIntegrate(robots[i], scenario.arenaMm);
+        }
+    }
+    states.resize(PERF_STATE_SAMPLES);
+    return states;
+}
+
+//-------------------------
+// IR frames
+//-------------------------
+std::vector<IRCorpusFrame> corpusIRFrames(uint32_t seed) {
+    std::vector<IRCorpusFrame> frames(PERF_IR_FRAMES);
+    uint32_t rng = seed ? seed : 1;
+
+    for (size_t f = 0; f < frames.size(); f++) {
+        IRCorpusFrame& frame = frames[f];
+        uint8_t payload[2] = {
+            (uint8_t)(nextRandom(&rng) % 16 + 1),   // id
+            (uint8_t)(nextRandom(&rng) % 4),        // role
+        };
+        frame.count = irEncodeFrame(payload, sizeof(payload), frame.items, IR_MAX_FRAME_ITEMS);
+
+        // What the receiver reports: inverted levels, +-40 us of timing jitter
+        for (size_t i = 0; i < frame.count; i++) {
+            rmt_item32_t& item = frame.items[i];
+            item.level0 = !item.level0;
+            item.level1 = !item.level1;
+            item.duration0 += (int)(nextRandom(&rng) % 81) - 40;
+            item.duration1 += (int)(nextRandom(&rng) % 81) - 40;
+        }
+
+        if (nextRandom(&rng) % 8 == 0) {
+            frame.items[1 + nextRandom(&rng) % (frame.count - 1)].duration0 = 150; // Glitch
+        }
+    }
+    return frames;
+}
+
+//-------------------------
+// MQTT commands
+//-------------------------
+std::vector<std::string> corpusCommands(uint32_t seed) {
+    static const char* const TEMPLATES[] = {
+        "{\"mode\": \"IDLE\", \"neighbor_maxDist\": %d, \"idle_thresh\": 300, \"sid\": 4242, \"seq\": %u}",
+        "{\"mode\": \"LINE\", \"neighbor_maxDist\": %d, \"line_nodeDist\": 300, \"line_alignTol\": 30, \"sid\": 4242, \"seq\": %u}",
+        "{\"mode\": \"POLYGON\", \"neighbor_maxDist\": %d, \"polygon_radius\": 300, \"polygon_sides\": 5, \"polygon_alignTol\": 30, \"sid\": 4242, \"seq\": %u}",
+        "{\"mode\": \"MANUAL\", \"l\": %d, \"r\": -200, \"b\": 0, \"sid\": 4242, \"seq\": %u}",
+        "{\"telemetry_hz\": %d, \"sid\": 4242, \"seq\": %u}",
+    };
+    const size_t templateCount = sizeof(TEMPLATES) / sizeof(TEMPLATES[0]);
+
+    std::vector<std::string> commands;
+    uint32_t rng = seed ? seed : 1;
+    char buffer[256];
+    for (uint32_t seq = 1; seq <= 256; seq++) {
+        const char* fmt = TEMPLATES[nextRandom(&rng) % templateCount];
+        snprintf(buffer, sizeof(buffer), fmt, (int)(nextRandom(&rng) % 500 + 100), seq);
+        commands.push_back(buffer);
+    }
+    return commands;
+}
+
+std::vector<std::string> corpusBatchCommands(uint32_t seed, int robots) {
+    std::vector<std::string> commands;
+    uint32_t rng = seed ? seed : 1;
+    char entry[96];
+    for (uint32_t seq = 1; seq <= 64; seq++) {
+        std::string cmd = "{\"mode\": \"LINE\", \"line_alignTol\": 30, \"sid\": 4242, \"seq\": " + std::to_string(seq) +
+                          ", \"robots\": {";
+        for (int r = 1; r <= robots; r++) {
+            snprintf(entry, sizeof(entry), "%s\"esp32_s3_%d\": {\"line_nodeDist\": %d, \"neighbor_maxDist\": %d}",
+                     r > 1 ? ", " : "", r, (int)(nextRandom(&rng) % 200 + 200), (int)(nextRandom(&rng) % 300 + 400));
+            cmd += entry;
+        }
+        cmd += "}}";
+        commands.push_back(cmd);
+    }
+    return commands;
+}
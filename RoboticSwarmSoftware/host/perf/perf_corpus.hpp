@@ -0,0 +1,33 @@
+#ifndef PERF_CORPUS_HPP
+#define PERF_CORPUS_HPP
+
+#include <string>
+#include <vector>
+#include "globals.hpp"
+#include "ir_codec.hpp"
+
+//Benchmark inputs. Formation states come from the swarm simulator, so the
+//planner sees the neighbour layouts it meets in practice; IR frames carry
+//receiver timing jitter and some glitches; commands are what the GUI sends.
+
+#define PERF_STATE_SAMPLES 512
+#define PERF_IR_FRAMES 128
+
+struct IRCorpusFrame {
+  rmt_item32_t items[IR_MAX_FRAME_ITEMS + 2];
+  size_t count;
+};
+
+//States captured every ToF frame from simulated runs of the given mode
+std::vector<State> corpusFormationStates(Config::Mode mode, uint32_t seed);
+
+//Received (level-inverted) beacon frames, about 1 in 8 with a corrupted item
+std::vector<IRCorpusFrame> corpusIRFrames(uint32_t seed);
+
+//MQTT command payloads: mode changes, formation updates, manual moves
+std::vector<std::string> corpusCommands(uint32_t seed);
+
+//Batched broadcasts with an entry for each of robots hostnames esp32_s3_1..N
+std::vector<std::string> corpusBatchCommands(uint32_t seed, int robots);
+
+#endif
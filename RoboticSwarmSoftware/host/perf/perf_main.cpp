@@ -0,0 +1,330 @@
+// Microbenchmarks for the firmware hot paths, built for the host.
+//   pio run -e native_perf && .pio/build/native_perf/program [options]
+//     --cycles            time with the CPU cycle counter instead of nanoseconds
+//     --save FILE         write the results as a baseline CSV
+//     --compare FILE      compare against a baseline, exit 1 on regressions
+//     --threshold PCT     slowdown that counts as a regression (default 10)
+//     --filter TEXT       only cases whose name contains TEXT
+//
+// Each case is tagged with the loop it sits in: "motor" for the 1 ms motor
+// tick (planner work), "step" for the step timer ISR, "network" for the MQTT
+// callback / report path, "ir" for the IR task. The report flags which of those a regression slows down.
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "perf_corpus.hpp"
+#include "motor_module.hpp"
+#include "command_ingest.hpp"
+#include "status_payload.hpp"
+#include "telemetry_frame.hpp"
+#include "ir_codec.hpp"
+#include "trajectory.hpp"
+#include "odometry.hpp"
+
+#define PERF_SAMPLES 201      // Timed batches per case, the median is reported
+#define PERF_BATCH 256        // Calls per batch, cycling through the corpus
+
+static bool useCycles = false;
+static volatile uint32_t sink;
+
+static std::vector<State> idleStates, lineStates, polygonStates;
+static std::vector<IRCorpusFrame> irFrames;
+static std::vector<std::string> commands;
+static std::vector<std::string> batchCommands;
+
+#define PERF_ROBOT_ID 7      // Address the benchmark answers to in batched commands
+#define PERF_BATCH_ROBOTS 32
+
+//-------------------------
+// Cases
+//-------------------------
+static uint32_t runSensorMaskIdle(uint32_t i) {
+    return getSensorMask_Idle(&idleStates[i % idleStates.size()]);
+}
+
+static uint32_t runDirectionIdle(uint32_t i) {
+    return getBestMoveDirection_Idle(getSensorMask_Idle(&idleStates[i % idleStates.size()]));
+}
+
+static uint32_t runBearingIdle(uint32_t i) {
+    return getBestMoveBearing_Idle(getSensorMask_Idle(&idleStates[i % idleStates.size()]));
+}
+
+static uint32_t runDirectionLine(uint32_t i) {
+    return getBestMoveDirection_Line(&lineStates[i % lineStates.size()]);
+}
+
+static uint32_t runBearingPolygon(uint32_t i) {
+    return getBestMoveBearing_Polygon(&polygonStates[i % polygonStates.size()], nullptr);
+}
+
+// Polar map fed the polygon frames in order, as the planner feeds it
+static PolarMap perfMap;
+
+static uint32_t runPolarMapAdd(uint32_t i) {
+    const State& s = polygonStates[i % polygonStates.size()];
+    polarMapAddFrame(&perfMap, s.distances, s.tof_validMask, s.pose_heading, s.neighbor_maxDist);
+    return perfMap.bins[0].weight;
+}
+
+static uint32_t runPolarMapContacts(uint32_t i) {
+    PolarContact contacts[POLAR_MAX_CONTACTS];
+    (void)i;
+    return polarMapContacts(&perfMap, contacts, POLAR_MAX_CONTACTS);
+}
+
+static uint32_t runBearingPolygonMap(uint32_t i) {
+    return getBestMoveBearing_Polygon(&polygonStates[i % polygonStates.size()], &perfMap);
+}
+
+// One motor tick of dead reckoning while turning along an arc
+static uint32_t runOdometryUpdate(uint32_t i) {
+    static Odometry odometry;
+    if (i == 0) odometryInit(&odometry, bodyToWheels(0, 0, 0));
+    WheelSteps wheels = bodyToWheels((int32_t)i, 0, (int32_t)(i / 4));
+    odometryUpdate(&odometry, wheels);
+    return odometry.headingMdeg;
+}
+
+// One 1 kHz trajectory update, wheels fed back as if they followed exactly.
+// Diagonal moves keep getting retargeted so blending and braking both run.
+static uint32_t runTrajectoryUpdate(uint32_t i) {
+    static Trajectory trajectory;
+    static int32_t position[TRAJ_AXES];
+    static int32_t fraction[TRAJ_AXES];
+    if (i == 0) trajectoryInit(&trajectory, 1000, 4000, 100000);
+
+    if (i % 400 == 0) {
+        int32_t relative[TRAJ_AXES] = {(int32_t)(i % 1200) - 300, 400, -(int32_t)(i % 700)};
+        trajectoryMove(&trajectory, position, relative);
+    }
+    uint32_t moving = trajectoryUpdate(&trajectory, position);
+    for (uint8_t a = 0; a < TRAJ_AXES; a++) {
+        fraction[a] += trajectory.velocity[a] / TRAJ_UPDATE_HZ;
+        position[a] += fraction[a] / (1 << TRAJ_Q);
+        fraction[a] %= (1 << TRAJ_Q);
+    }
+    return moving;
+}
+
+static uint32_t runIRDecodeFrame(uint32_t i) {
+    static IRDecoder decoder;
+    const IRCorpusFrame& frame = irFrames[i % irFrames.size()];
+    uint32_t decoded = 0;
+    for (size_t k = 0; k < frame.count; k++) decoded += irDecoderFeed(&decoder, frame.items[k]);
+    return decoded;
+}
+
+static uint32_t runParseCommand(uint32_t i) {
+    static ReplayWindow window;
+    const std::string& cmd = commands[i % commands.size()];
+    ParsedCommand parsed;
+    if (parseCommand((const uint8_t*)cmd.data(), cmd.size(), &parsed)) return 0;
+    window.primed = false; // Every pass replays the same numbers, keep them all fresh
+    return replayWindowAccept(&window, parsed.session, parsed.seq) + parsed.hasMode;
+}
+
+static uint32_t runParseBatch(uint32_t i) {
+    const std::string& cmd = batchCommands[i % batchCommands.size()];
+    ParsedCommand parsed;
+    if (parseCommand((const uint8_t*)cmd.data(), cmd.size(), &parsed)) return 0;
+    return parsed.hasBatchEntry + parsed.lineNodeDist;
+}
+
+static uint32_t runStatusPayload(uint32_t i) {
+    static char buffer[1024];
+    (void)i;
+    buildStatusPayload(buffer, sizeof(buffer));
+    return buffer[0];
+}
+
+// Same report as buildStatusPayload in the binary form, from a planner snapshot
+static uint32_t runTelemetryFrame(uint32_t i) {
+    TelemetryFrame frame;
+    buildTelemetryFrame(&frame, polygonStates[i % polygonStates.size()], PERF_ROBOT_ID, i, i, i, i);
+    return frame.distances[0] + frame.neighborIds[0];
+}
+
+static uint32_t runStatsPayload(uint32_t i) {
+    static char buffer[1536];
+    (void)i;
+    buildStatsPayload(buffer, sizeof(buffer));
+    return buffer[0];
+}
+
+struct PerfCase {
+    const char* name;
+    const char* loop;
+    uint32_t (*run)(uint32_t i);
+};
+
+static const PerfCase CASES[] = {
+    {"getSensorMask_Idle",          "motor",   runSensorMaskIdle},
+    {"getBestMoveDirection_Idle",   "motor",   runDirectionIdle},
+    {"getBestMoveBearing_Idle",     "motor",   runBearingIdle},
+    {"getBestMoveDirection_Line",   "motor",   runDirectionLine},
+    {"getBestMoveBearing_Polygon",  "motor",   runBearingPolygon},
+    {"polarMapAddFrame",            "motor",   runPolarMapAdd},
+    {"polarMapContacts",            "motor",   runPolarMapContacts},
+    {"getBestMoveBearing_PolyMap",  "motor",   runBearingPolygonMap},
+    {"odometryUpdate",              "motor",   runOdometryUpdate},
+    {"trajectoryUpdate",            "step",    runTrajectoryUpdate},
+    {"irDecoderFeed_frame",         "ir",      runIRDecodeFrame},
+    {"parseCommand",                "network", runParseCommand},
+    {"parseCommand_batch32",        "network", runParseBatch},
+    {"buildStatusPayload",          "network", runStatusPayload},
+    {"buildTelemetryFrame",         "network", runTelemetryFrame},
+    {"buildStatsPayload",           "network", runStatsPayload},
+};
+
+#define CASE_COUNT (sizeof(CASES) / sizeof(CASES[0]))
+
+//-------------------------
+// Timing
+//-------------------------
+static uint64_t now() {
+    if (useCycles) return ESP.getCycleCount();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct PerfResult {
+    double median;
+    double p90;
+};
+
+static PerfResult measure(const PerfCase& c) {
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < PERF_BATCH * 4; i++) acc += c.run(i); // Warm caches and predictors
+
+    std::vector<double> samples;
+    uint32_t index = 0;
+    for (int s = 0; s < PERF_SAMPLES; s++) {
+        uint64_t start = now();
+        for (int k = 0; k < PERF_BATCH; k++) acc += c.run(index++);
+        uint32_t elapsed = (uint32_t)(now() - start); // Cycle counter is 32 bits
+        samples.push_back((double)elapsed / PERF_BATCH);
+    }
+    sink = acc;
+
+    std::sort(samples.begin(), samples.end());
+    PerfResult r;
+    r.median = samples[samples.size() / 2];
+    r.p90 = samples[samples.size() * 9 / 10];
+    return r;
+}
+
+//-------------------------
+// Baselines
+//-------------------------
+static std::map<std::string, double> loadBaseline(const char* path, std::string* unit) {
+    std::map<std::string, double> baseline;
+    FILE* f = fopen(path, "r");
+    if (!f) return baseline;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char name[128], loop[32], fileUnit[16];
+        double median, p90;
+        if (sscanf(line, "%127[^,],%31[^,],%15[^,],%lf,%lf", name, loop, fileUnit, &median, &p90) == 5) {
+            baseline[name] = median;
+            *unit = fileUnit;
+        }
+    }
+    fclose(f);
+    return baseline;
+}
+
+int main(int argc, char** argv) {
+    const char* savePath = nullptr;
+    const char* comparePath = nullptr;
+    const char* filter = "";
+    double threshold = 10;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--cycles")) useCycles = true;
+        else if (!strcmp(argv[i], "--save") && hasValue) savePath = argv[++i];
+        else if (!strcmp(argv[i], "--compare") && hasValue) comparePath = argv[++i];
+        else if (!strcmp(argv[i], "--threshold") && hasValue) threshold = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--filter") && hasValue) filter = argv[++i];
+        else {
+            fprintf(stderr, "unknown option %s (see the header of perf_main.cpp)\n", argv[i]);
+            return 2;
+        }
+    }
+    const char* unit = useCycles ? "cycles" : "ns";
+
+    // Corpora, fixed seeds so runs compare
+    idleStates = corpusFormationStates(Config::IDLE, 11);
+    lineStates = corpusFormationStates(Config::LINE, 12);
+    polygonStates = corpusFormationStates(Config::POLYGON, 13);
+    irFrames = corpusIRFrames(14);
+    commands = corpusCommands(15);
+    batchCommands = corpusBatchCommands(16, PERF_BATCH_ROBOTS);
+    setCommandAddress("esp32_s3_7", PERF_ROBOT_ID);
+
+    // Status reports read the shared state, give them a realistic one
+    configLock.write(polygonStates[0]);
+    sensorLock.write(polygonStates[0]);
+    neighborLock.write(polygonStates[0]);
+
+    std::string baselineUnit;
+    std::map<std::string, double> baseline;
+    if (comparePath) {
+        baseline = loadBaseline(comparePath, &baselineUnit);
+        if (baseline.empty()) {
+            fprintf(stderr, "no baseline in %s\n", comparePath);
+            return 2;
+        }
+        if (baselineUnit != unit) {
+            fprintf(stderr, "baseline is in %s, this run in %s\n", baselineUnit.c_str(), unit);
+            return 2;
+        }
+    }
+
+    FILE* save = savePath ? fopen(savePath, "w") : nullptr;
+    int regressions = 0;
+    std::map<std::string, int> slowedLoops;
+
+    printf("%-28s %-8s %12s %12s %10s\n", "case", "loop", (std::string("median ") + unit).c_str(),
+           (std::string("p90 ") + unit).c_str(), comparePath ? "vs base" : "");
+
+    for (size_t c = 0; c < CASE_COUNT; c++) {
+        const PerfCase& pc = CASES[c];
+        if (!strstr(pc.name, filter)) continue;
+
+        PerfResult r = measure(pc);
+        printf("%-28s %-8s %12.1f %12.1f", pc.name, pc.loop, r.median, r.p90);
+
+        if (comparePath && baseline.count(pc.name)) {
+            double change = (r.median / baseline[pc.name] - 1) * 100;
+            bool regressed = change > threshold;
+            printf(" %+9.1f%%%s", change, regressed ? "  REGRESSION" : "");
+            if (regressed) {
+                regressions++;
+                slowedLoops[pc.loop]++;
+            }
+        }
+        printf("\n");
+
+        if (save) fprintf(save, "%s,%s,%s,%.2f,%.2f\n", pc.name, pc.loop, unit, r.median, r.p90);
+    }
+    if (save) fclose(save);
+
+    if (comparePath) {
+        if (regressions == 0) {
+            printf("\nno regressions beyond %.0f%%\n", threshold);
+        } else {
+            printf("\n%d regression(s) beyond %.0f%%:\n", regressions, threshold);
+            if (slowedLoops.count("motor")) printf("  slows the 1 ms motor loop (planner)\n");
+            if (slowedLoops.count("step")) printf("  slows the step timer ISR (trajectory)\n");
+            if (slowedLoops.count("network")) printf("  slows the MQTT callback / report path\n");
+            if (slowedLoops.count("ir")) printf("  slows IR frame decoding\n");
+        }
+    }
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,20 @@
+#ifndef HOST_RMT_SHIM_H
+#define HOST_RMT_SHIM_H
+
+// The RMT item layout from ESP-IDF's driver/rmt.h, all ir_codec.cpp needs
+
+#include <stdint.h>
+
+typedef struct {
+    union {
+        struct {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_item32_t;
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef HOST_ESP_TIMER_SHIM_H
+#define HOST_ESP_TIMER_SHIM_H
+
+// esp_timer_get_time() stand-in: µs since the program started, 64 bit like the real one
+
+#include <chrono>
+#include <stdint.h>
+
+inline int64_t esp_timer_get_time() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (int64_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+#endif
@@ -0,0 +1,36 @@
+// flight_recorder.hpp for the simulator: decisions feed the per-robot
+// formation metrics instead of a RAM ring.
+#include "swarm_sim.hpp"
+#include "flight_recorder.hpp"
+
+void recordTofFrame(const uint32_t* distances, uint8_t validMask, uint32_t frameSeq) {
+    (void)distances;
+    (void)validMask;
+    (void)frameSeq;
+}
+
+void recordMotorTarget(int left, int right, int back) {
+    (void)left;
+    (void)right;
+    (void)back;
+}
+
+void recordDecision(uint8_t mode, int result, bool isBearing) {
+    (void)mode;
+    SimRobot* robot = simCurrentRobot;
+    robot->decisions++;
+
+    bool inPosition = (result == -2);
+    if (inPosition != robot->inPosition) robot->toggles++;
+    robot->inPosition = inPosition;
+
+    if (result < 0) return; // Search or stop, no bearing
+
+    int bearing = isBearing ? result : result * 60;
+    if (robot->hasBearing) {
+        int diff = abs(((bearing - robot->lastBearing) % 360 + 540) % 360 - 180);
+        if (diff > 120) robot->reversals++;
+    }
+    robot->lastBearing = bearing;
+    robot->hasBearing = true;
+}
@@ -0,0 +1,200 @@
+// Swarm simulator driver: scenarios, worker threads and the metrics report.
+//   pio run -e native_sim && .pio/build/native_sim/program [options]
+//     --scenario NAME   run scenarios whose name contains NAME (default: all)
+//     --robots N        override the robot count
+//     --seconds S       override the simulated duration
+//     --threads T       worker threads (default: all cores)
+//     --seed X          placement / noise seed (default 1)
+//     --list            list scenarios and exit
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "swarm_sim.hpp"
+#include "motor_module.hpp"
+
+//-------------------------
+// Scenarios
+//-------------------------
+static Config makeConfig(uint16_t maxDist, uint16_t idleThresh, uint16_t lineDist, uint16_t lineTol,
+                         uint8_t sides, uint16_t radius, uint16_t polygonTol) {
+    Config c = Config();
+    c.neighbor_maxDist = maxDist;
+    c.idle_thresh = idleThresh;
+    c.line_nodeDist = lineDist;
+    c.line_alignTol = lineTol;
+    c.polygon_sides = sides;
+    c.polygon_radius = radius;
+    c.polygon_alignTol = polygonTol;
+    return c;
+}
+
+static const SimScenario SCENARIOS[] = {
+    // name               mode             N    arena  spawn  s    maxDist idle line tol sides radius tol
+    {"idle_spread_20",    Config::IDLE,    20,  4000,  600,   30, makeConfig(600, 300, 0, 0, 3, 0, 0)},
+    {"idle_spread_200",   Config::IDLE,    200, 12000, 2500,  30, makeConfig(600, 300, 0, 0, 3, 0, 0)},
+    {"line_3",            Config::LINE,    3,   3000,  400,   40, makeConfig(700, 0, 300, 30, 3, 0, 0)},
+    {"line_5",            Config::LINE,    5,   4000,  600,   60, makeConfig(700, 0, 300, 30, 3, 0, 0)},
+    {"polygon_3",         Config::POLYGON, 3,   3000,  400,   40, makeConfig(800, 0, 0, 0, 3, 300, 30)},
+};
+
+#define SCENARIO_COUNT (sizeof(SCENARIOS) / sizeof(SCENARIOS[0]))
+
+//-------------------------
+// Worker synchronisation
+//-------------------------
+class Barrier {
+public:
+    explicit Barrier(int count) : count(count), waiting(0), generation(0) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        uint32_t gen = generation;
+        if (++waiting == count) {
+            waiting = 0;
+            generation++;
+            cv.notify_all();
+        } else {
+            cv.wait(lock, [&] { return gen != generation; });
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    int count;
+    int waiting;
+    uint32_t generation;
+};
+
+//-------------------------
+// Simulation
+//-------------------------
+SimResult simRunScenario(const SimScenario& scenario, int threads, uint32_t seed) {
+    std::vector<SimRobot> robots;
+    simInitRobots(robots, scenario, seed);
+
+    const uint32_t ticks = scenario.seconds * 1000 / SIM_TICK_MS;
+    const int workers = max(1, min(threads, scenario.robots));
+    Barrier barrier(workers);
+
+    std::vector<uint32_t> contacts(workers, 0);
+    int64_t holdStart = -1;
+    int64_t formedAt = -1;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Each tick: everyone senses from the same poses, then everyone plans and moves.
+    // Worker w owns robots w, w + workers, ...
+    auto work = [&](int w) {
+        uint32_t rng = seed * 2654435761u + w + 1;
+
+        for (uint32_t t = 0; t < ticks; t++) {
+            uint32_t nowMs = t * SIM_TICK_MS;
+
+            for (size_t i = w; i < robots.size(); i += workers) {
+                if ((nowMs + robots[i].framePhaseMs) % SIM_TOF_PERIOD_MS == 0) {
+                    contacts[w] += simSense(robots[i], robots, scenario.arenaMm, &rng);
+                }
+            }
+
+            // Formation check, reads what the last move phase wrote
+            if (w == 0) {
+                bool all = true;
+                for (size_t i = 0; i < robots.size() && all; i++) all = robots[i].inPosition;
+                if (!all) holdStart = -1;
+                else if (holdStart < 0) holdStart = nowMs;
+                if (formedAt < 0 && holdStart >= 0 && nowMs - holdStart >= SIM_HOLD_MS) formedAt = holdStart;
+            }
+            barrier.wait();
+
+            for (size_t i = w; i < robots.size(); i += workers) {
+                SimRobot& robot = robots[i];
+                simCurrentRobot = &robot;
+                if (robot.frameFresh) {
+                    handleMotors(&robot.state, SIM_STEPS_TO_SCOOT, &robot.polarMap); // As motorTask does on a new frame
+                    robot.frameFresh = false;
+                }
+                simIntegrate(robot, scenario.arenaMm);
+            }
+            barrier.wait();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int w = 1; w < workers; w++) pool.push_back(std::thread(work, w));
+    work(0);
+    for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+
+    SimResult result = SimResult();
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.formedAtS = (formedAt >= 0) ? formedAt / 1000.0 : -1;
+
+    double reversals = 0, toggles = 0, path = 0;
+    for (size_t i = 0; i < robots.size(); i++) {
+        reversals += robots[i].reversals;
+        toggles += robots[i].toggles;
+        path += robots[i].pathMm;
+    }
+    double n = robots.size();
+    result.reversalsPerRobotS = reversals / n / scenario.seconds;
+    result.togglesPerRobot = toggles / n;
+    result.pathPerRobotMm = path / n;
+    for (int w = 0; w < workers; w++) result.contacts += contacts[w];
+    return result;
+}
+
+//-------------------------
+// Entry point
+//-------------------------
+int main(int argc, char** argv) {
+    const char* filter = "";
+    int robotsOverride = 0;
+    int secondsOverride = 0;
+    int threads = max(1u, std::thread::hardware_concurrency());
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--list")) {
+            for (size_t s = 0; s < SCENARIO_COUNT; s++) printf("%s\n", SCENARIOS[s].name);
+            return 0;
+        } else if (!strcmp(argv[i], "--scenario") && hasValue) {
+            filter = argv[++i];
+        } else if (!strcmp(argv[i], "--robots") && hasValue) {
+            robotsOverride = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--seconds") && hasValue) {
+            secondsOverride = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--threads") && hasValue) {
+            threads = max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--seed") && hasValue) {
+            seed = strtoul(argv[++i], nullptr, 0);
+        } else {
+            fprintf(stderr, "unknown option %s (see the header of sim_main.cpp)\n", argv[i]);
+            return 2;
+        }
+    }
+
+    printf("%-18s %6s %7s %10s %12s %10s %10s %9s %8s\n", "scenario", "robots", "sim_s", "formed_s",
+           "reversals/s", "toggles", "path_mm", "contacts", "speedup");
+
+    for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+        SimScenario scenario = SCENARIOS[s];
+        if (!strstr(scenario.name, filter)) continue;
+        if (robotsOverride > 0) scenario.robots = robotsOverride;
+        if (secondsOverride > 0) scenario.seconds = secondsOverride;
+
+        SimResult r = simRunScenario(scenario, threads, seed);
+
+        char formed[16];
+        if (r.formedAtS >= 0) snprintf(formed, sizeof(formed), "%.2f", r.formedAtS);
+        else snprintf(formed, sizeof(formed), "never");
+
+        printf("%-18s %6d %7u %10s %12.3f %10.1f %10.0f %9u %7.1fx\n", scenario.name, scenario.robots,
+               scenario.seconds, formed, r.reversalsPerRobotS, r.togglesPerRobot, r.pathPerRobotMm, r.contacts,
+               scenario.seconds / r.wallSeconds);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+// step_engine.hpp for the simulator: the calling thread's current robot
+// owns the axes. The profile itself is integrated by simIntegrate().
+#include "swarm_sim.hpp"
+#include "motor_module.hpp"
+
+void initStepEngine(const uint8_t stepPins[STEP_AXIS_COUNT], const uint8_t dirPins[STEP_AXIS_COUNT]) {
+    (void)stepPins;
+    (void)dirPins;
+}
+
+void stepEngineSetLimits(uint8_t axis, uint32_t maxSpeed, uint32_t accel) {
+    if (axis >= STEP_AXIS_COUNT) return;
+    simCurrentRobot->axes[axis].maxSpeed = maxSpeed;
+    simCurrentRobot->axes[axis].accel = accel;
+}
+
+void stepEngineMove(uint8_t axis, int32_t relative) {
+    if (axis >= STEP_AXIS_COUNT) return;
+    SimAxis& ax = simCurrentRobot->axes[axis];
+    simCurrentRobot->coordinated = false;
+    ax.target = (int32_t)lround(ax.position) + relative;
+    ax.stopRequested = false;
+}
+
+void stepEngineSetTrajectoryLimits(uint32_t maxSpeed, uint32_t accel, uint32_t jerk) {
+    trajectoryInit(&simCurrentRobot->trajectory, min<uint32_t>(maxSpeed, STEP_TICK_HZ / 2), accel, jerk);
+}
+
+void stepEngineMoveCoordinated(const int32_t relative[STEP_AXIS_COUNT]) {
+    SimRobot& robot = *simCurrentRobot;
+    int32_t position[STEP_AXIS_COUNT];
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        position[i] = (int32_t)lround(robot.axes[i].position);
+        if (!robot.coordinated) robot.trajectory.velocity[i] = (int32_t)(robot.axes[i].speed * (1 << TRAJ_Q));
+    }
+    trajectoryMove(&robot.trajectory, position, relative);
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        robot.axes[i].target = robot.trajectory.target[i];
+        robot.axes[i].stopRequested = false;
+    }
+    robot.coordinated = true;
+}
+
+void stepEngineStopCoordinated() {
+    SimRobot& robot = *simCurrentRobot;
+    int32_t position[STEP_AXIS_COUNT];
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) position[i] = (int32_t)lround(robot.axes[i].position);
+    if (robot.coordinated) {
+        trajectoryStop(&robot.trajectory, position);
+        for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) robot.axes[i].target = robot.trajectory.target[i];
+    } else {
+        for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) robot.axes[i].stopRequested = true;
+    }
+}
+
+void stepEngineStop(uint8_t axis) {
+    if (axis >= STEP_AXIS_COUNT) return;
+    simCurrentRobot->axes[axis].stopRequested = true;
+}
+
+int32_t stepEnginePosition(uint8_t axis) {
+    if (axis >= STEP_AXIS_COUNT) return 0;
+    return (int32_t)lround(simCurrentRobot->axes[axis].position);
+}
+
+int32_t stepEngineDistanceToGo(uint8_t axis) {
+    if (axis >= STEP_AXIS_COUNT) return 0;
+    const SimAxis& ax = simCurrentRobot->axes[axis];
+    return ax.target - (int32_t)lround(ax.position);
+}
@@ -0,0 +1,260 @@
+// Arena physics: robot placement, ray-cast sensing, wheel odometry.
+#include "swarm_sim.hpp"
+#include "motor_module.hpp"
+
+#define DEG_TO_RAD (M_PI / 180.0)
+
+// Step engine axis order and wheel signs, as in motor_module.cpp
+#define AXIS_RIGHT 0
+#define AXIS_LEFT 1
+#define AXIS_BACK 2
+
+thread_local SimRobot* simCurrentRobot = nullptr;
+
+//-------------------------
+// Random numbers (deterministic per seed, no shared state)
+//-------------------------
+static uint32_t nextRandom(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static double uniform(uint32_t* state) {
+    return (nextRandom(state) >> 8) * (1.0 / 16777216.0);
+}
+
+// Approximate N(0, 1) from the sum of four uniforms
+static double gaussian(uint32_t* state) {
+    return (uniform(state) + uniform(state) + uniform(state) + uniform(state) - 2.0) * 1.7320508;
+}
+
+//-------------------------
+// Setup
+//-------------------------
+// Whole steps taken per wheel in setMotorSteps() terms, what odometry sees
+static WheelSteps wheelTravel(const SimRobot& robot) {
+    WheelSteps w;
+    w.left = -(int32_t)lround(robot.axes[AXIS_LEFT].position);
+    w.right = (int32_t)lround(robot.axes[AXIS_RIGHT].position);
+    w.back = (int32_t)lround(robot.axes[AXIS_BACK].position);
+    return w;
+}
+
+void simInitRobots(std::vector<SimRobot>& robots, const SimScenario& scenario, uint32_t seed) {
+    uint32_t rng = seed ? seed : 1;
+    robots.assign(scenario.robots, SimRobot());
+
+    for (int i = 0; i < scenario.robots; i++) {
+        SimRobot& r = robots[i];
+        memset(&r, 0, sizeof(r));
+        r.id = i + 1;
+
+        // Rejection-sample a spot in the spawn disk that doesn't overlap anyone
+        for (int attempt = 0; attempt < 1000; attempt++) {
+            double angle = uniform(&rng) * 2 * M_PI;
+            double dist = sqrt(uniform(&rng)) * scenario.spawnRadiusMm;
+            r.x = scenario.arenaMm / 2 + dist * cos(angle);
+            r.y = scenario.arenaMm / 2 + dist * sin(angle);
+
+            bool clear = true;
+            for (int j = 0; j < i && clear; j++) {
+                clear = hypot(r.x - robots[j].x, r.y - robots[j].y) > 2.5 * SIM_ROBOT_RADIUS_MM;
+            }
+            if (clear) break;
+        }
+        r.headingDeg = uniform(&rng) * 360.0;
+        r.framePhaseMs = nextRandom(&rng) % SIM_TOF_PERIOD_MS;
+
+        static_cast<Config&>(r.state) = scenario.config;
+        r.state.mode = scenario.mode;
+        for (int d = 0; d < 6; d++) {
+            r.state.distances[d] = SIM_TOF_NO_TARGET_MM;
+            r.state.neighbor_ids[d] = -1;
+        }
+    }
+
+    // Motor limits go to the simulated step engine of the current robot
+    for (int i = 0; i < scenario.robots; i++) {
+        simCurrentRobot = &robots[i];
+        initMotors(0, 0, 0, 0, 0, 0); // Pins unused here
+        odometryInit(&robots[i].odometry, wheelTravel(robots[i]));
+    }
+    simCurrentRobot = nullptr;
+}
+
+//-------------------------
+// Sensing
+//-------------------------
+// Distance along (dx, dy) from (ox, oy) to a circle, or -1 for a miss
+static double rayCircle(double ox, double oy, double dx, double dy, double cx, double cy, double radius) {
+    double fx = ox - cx, fy = oy - cy;
+    double b = fx * dx + fy * dy;
+    double c = fx * fx + fy * fy - radius * radius;
+    double disc = b * b - c;
+    if (disc < 0) return -1;
+    double t = -b - sqrt(disc);
+    return (t >= 0) ? t : -1;
+}
+
+// Distance to the arena wall along (dx, dy), the origin is inside
+static double rayWall(double ox, double oy, double dx, double dy, double arenaMm) {
+    double t = 1e12;
+    if (dx > 1e-9) t = min(t, (arenaMm - ox) / dx);
+    if (dx < -1e-9) t = min(t, -ox / dx);
+    if (dy > 1e-9) t = min(t, (arenaMm - oy) / dy);
+    if (dy < -1e-9) t = min(t, -oy / dy);
+    return t;
+}
+
+uint32_t simSense(SimRobot& robot, const std::vector<SimRobot>& robots, double arenaMm, uint32_t* rng) {
+    const double reach = SIM_TOF_MAX_MM + 2 * SIM_ROBOT_RADIUS_MM;
+    uint32_t contacts = 0;
+
+    // Robots close enough to matter, the only ones ray-cast against
+    std::vector<const SimRobot*> nearby;
+    for (size_t j = 0; j < robots.size(); j++) {
+        const SimRobot& other = robots[j];
+        if (&other == &robot) continue;
+        double dist = hypot(other.x - robot.x, other.y - robot.y);
+        if (dist > reach) continue;
+        if (dist < 2 * SIM_ROBOT_RADIUS_MM) contacts++;
+        nearby.push_back(&other);
+    }
+
+    uint8_t validMask = 0;
+    for (int i = 0; i < 6; i++) {
+        double sensorDeg = robot.headingDeg + i * 60;
+        double ox = robot.x + SIM_ROBOT_RADIUS_MM * cos(sensorDeg * DEG_TO_RAD);
+        double oy = robot.y + SIM_ROBOT_RADIUS_MM * sin(sensorDeg * DEG_TO_RAD);
+
+        double best = 1e12;
+        const SimRobot* hitRobot = nullptr;
+        for (int ray = -1; ray <= 1; ray++) {
+            double a = (sensorDeg + ray * SIM_TOF_HALF_FOV_DEG) * DEG_TO_RAD;
+            double dx = cos(a), dy = sin(a);
+
+            double wall = rayWall(ox, oy, dx, dy, arenaMm);
+            if (wall < best) {
+                best = wall;
+                hitRobot = nullptr;
+            }
+            for (size_t n = 0; n < nearby.size(); n++) {
+                double t = rayCircle(ox, oy, dx, dy, nearby[n]->x, nearby[n]->y, SIM_ROBOT_RADIUS_MM);
+                if (t >= 0 && t < best) {
+                    best = t;
+                    hitRobot = nearby[n];
+                }
+            }
+        }
+
+        double measured = best + 5.0 * gaussian(rng); // ~5 mm ranging noise
+        if (measured < SIM_TOF_MAX_MM) {
+            robot.state.distances[i] = (uint32_t)max(0.0, measured);
+            validMask |= (1 << i);
+        } else {
+            robot.state.distances[i] = SIM_TOF_NO_TARGET_MM;
+        }
+
+        // IR: a robot in view lights the receiver and its beacon decodes
+        robot.state.neighbor_ids[i] = hitRobot ? hitRobot->id : -1;
+        robot.state.ir_quality[i] = hitRobot ? 255 : 0;
+    }
+
+    robot.state.tof_validMask = validMask;
+    robot.state.tof_frameSeq++;
+    robot.state.ir_cycleSeq++;
+    robot.frameFresh = true;
+    return contacts;
+}
+
+//-------------------------
+// Motion
+//-------------------------
+// One tick of the trapezoidal profile, same behaviour as the step ISR
+static void integrateAxis(SimAxis& ax, double dt) {
+    double accel = ax.accel ? ax.accel : 1;
+    double togo = ax.target - ax.position;
+    double stopDist = ax.speed * ax.speed / (2 * accel);
+    bool wrongWay = (ax.speed > 0 && togo < 0) || (ax.speed < 0 && togo > 0);
+
+    if (ax.stopRequested || wrongWay || fabs(togo) <= stopDist || fabs(ax.speed) > ax.maxSpeed) {
+        // Decelerate towards rest
+        double dv = min(fabs(ax.speed), accel * dt);
+        ax.speed -= (ax.speed > 0) ? dv : -dv;
+        if (ax.stopRequested && ax.speed == 0) {
+            ax.target = (int32_t)lround(ax.position);
+            ax.stopRequested = false;
+        }
+    } else if (fabs(togo) >= 0.5) {
+        double dir = (togo > 0) ? 1 : -1;
+        ax.speed = dir * min((double)ax.maxSpeed, fabs(ax.speed) + accel * dt);
+    }
+
+    double before = ax.target - ax.position;
+    ax.position += ax.speed * dt;
+    double after = ax.target - ax.position;
+
+    // Arrived (or crossed the target at crawl speed): settle on it
+    if (!ax.stopRequested && (before > 0) != (after > 0) && fabs(ax.speed) <= 2 * accel * dt) {
+        ax.position = ax.target;
+        ax.speed = 0;
+    }
+}
+
+// One tick in coordinated mode: the trajectory sets the wheel speeds
+static void integrateCoordinated(SimRobot& robot, double dt) {
+    int32_t position[STEP_AXIS_COUNT];
+    for (int a = 0; a < STEP_AXIS_COUNT; a++) position[a] = (int32_t)lround(robot.axes[a].position);
+    trajectoryUpdate(&robot.trajectory, position);
+
+    for (int a = 0; a < STEP_AXIS_COUNT; a++) {
+        SimAxis& ax = robot.axes[a];
+        ax.speed = robot.trajectory.velocity[a] / (double)(1 << TRAJ_Q);
+        ax.position += ax.speed * dt;
+    }
+}
+
+static void updatePose(SimRobot& robot) {
+    if (!odometryUpdate(&robot.odometry, wheelTravel(robot))) return;
+    robot.state.pose_x = robot.odometry.xUm / 1000;
+    robot.state.pose_y = robot.odometry.yUm / 1000;
+    robot.state.pose_heading = (int16_t)(robot.odometry.headingMdeg / 100);
+    robot.state.pose_seq++;
+}
+
+void simIntegrate(SimRobot& robot, double arenaMm) {
+    double before[STEP_AXIS_COUNT];
+    for (int a = 0; a < STEP_AXIS_COUNT; a++) {
+        before[a] = robot.axes[a].position;
+    }
+    if (robot.coordinated) {
+        integrateCoordinated(robot, SIM_TICK_MS / 1000.0);
+    } else {
+        for (int a = 0; a < STEP_AXIS_COUNT; a++) integrateAxis(robot.axes[a], SIM_TICK_MS / 1000.0);
+    }
+
+    // Wheel travel in setMotorSteps() terms (the left axis runs inverted)
+    double l = -(robot.axes[AXIS_LEFT].position - before[AXIS_LEFT]);
+    double r = robot.axes[AXIS_RIGHT].position - before[AXIS_RIGHT];
+    double b = robot.axes[AXIS_BACK].position - before[AXIS_BACK];
+    if (l == 0 && r == 0 && b == 0) return;
+    updatePose(robot);
+
+    // Inverse of bodyToWheels(): l = vx - vy/sqrt3 + s, r = -2vy/sqrt3 - s, b = vx + vy/sqrt3 - s
+    double vx = (l + b) / 2;
+    double spin = (l - b - r) / 3;
+    double vy = -(r + spin) * sqrt(3.0) / 2;
+    double spinDeg = spin * 9.0 / 14.0;         // 14 wheel steps per 9 deg, clockwise
+
+    double h = robot.headingDeg * DEG_TO_RAD;
+    double dx = (vx * cos(h) - vy * sin(h)) * SIM_MM_PER_STEP;
+    double dy = (vx * sin(h) + vy * cos(h)) * SIM_MM_PER_STEP;
+
+    robot.x = constrain(robot.x + dx, SIM_ROBOT_RADIUS_MM, arenaMm - SIM_ROBOT_RADIUS_MM);
+    robot.y = constrain(robot.y + dy, SIM_ROBOT_RADIUS_MM, arenaMm - SIM_ROBOT_RADIUS_MM);
+    robot.headingDeg = fmod(robot.headingDeg - spinDeg + 360.0, 360.0);
+    robot.pathMm += hypot(dx, dy);
+}
@@ -0,0 +1,89 @@
+#ifndef SWARM_SIM_HPP
+#define SWARM_SIM_HPP
+
+#include <Arduino.h>
+#include <vector>
+#include "globals.hpp"
+#include "step_engine.hpp"
+#include "trajectory.hpp"
+#include "odometry.hpp"
+#include "polar_map.hpp"
+
+//Host-native swarm simulator. Every robot runs the real formation logic
+//(handleMotors() from motor_module.cpp) against simulated steppers, ray-cast
+//ToF sensors and ideal IR identification in a rectangular arena.
+
+#define SIM_TICK_MS 1               // Physics / step engine resolution
+#define SIM_TOF_PERIOD_MS 20        // Same frame rate as TOFsensorTask
+#define SIM_TOF_MAX_MM 2000         // TOF_MAX_VALID_MM
+#define SIM_TOF_NO_TARGET_MM 8190   // TOF_NO_TARGET_MM
+#define SIM_TOF_HALF_FOV_DEG 12.5   // VL53L0X ~25 deg cone, sampled with 3 rays
+#define SIM_ROBOT_RADIUS_MM 60.0
+#define SIM_MM_PER_STEP 0.628       // 40 mm wheel, 200 steps/rev
+#define SIM_STEPS_TO_SCOOT 100      // motorTask's handleMotors(&localState, 100, &polarMap)
+#define SIM_HOLD_MS 1000            // All robots in position this long = formed
+
+struct SimAxis {
+  double position;          // Steps, fractional
+  double speed;             // Steps/s, signed
+  int32_t target;
+  uint32_t maxSpeed;
+  uint32_t accel;
+  bool stopRequested;
+};
+
+struct SimRobot {
+  int id;
+  double x, y;              // mm, world frame
+  double headingDeg;        // World angle of body x (sensor 0), counter-clockwise
+  SimAxis axes[STEP_AXIS_COUNT];
+  Trajectory trajectory;    // Coordinated mode, same planner the step ISR runs
+  bool coordinated;
+  Odometry odometry;        // Fills state's pose the way motorTask does
+  PolarMap polarMap;        // The planner's range map, one per robot
+  State state;              // What handleMotors() sees
+  uint32_t framePhaseMs;    // Staggers ToF frames across robots
+  bool frameFresh;
+
+  // Metrics, fed by the flight recorder hooks
+  bool inPosition;
+  bool hasBearing;
+  int lastBearing;
+  uint32_t decisions;
+  uint32_t reversals;       // Consecutive moves more than 120 deg apart
+  uint32_t toggles;         // In position <-> moving transitions
+  double pathMm;
+};
+
+struct SimScenario {
+  const char* name;
+  Config::Mode mode;
+  int robots;
+  double arenaMm;           // Square arena side
+  double spawnRadiusMm;     // Robots start inside this disk at the arena centre
+  uint32_t seconds;
+  Config config;
+};
+
+struct SimResult {
+  double formedAtS;         // -1 if never
+  double reversalsPerRobotS;
+  double togglesPerRobot;
+  double pathPerRobotMm;
+  uint32_t contacts;        // Robot/robot overlaps seen while sensing
+  double wallSeconds;
+};
+
+//Robot the calling thread is currently simulating, used by the step engine
+//and flight recorder hooks
+extern thread_local SimRobot* simCurrentRobot;
+
+void simInitRobots(std::vector<SimRobot>& robots, const SimScenario& scenario, uint32_t seed);
+//ToF + IR frame for one robot from everyone's current poses, returns overlaps seen
+uint32_t simSense(SimRobot& robot, const std::vector<SimRobot>& robots, double arenaMm, uint32_t* rng);
+//Advances the robot's step engine by one tick and moves it accordingly
+void simIntegrate(SimRobot& robot, double arenaMm);
+
+SimResult simRunScenario(const SimScenario& scenario, int threads, uint32_t seed);
+
+#endif
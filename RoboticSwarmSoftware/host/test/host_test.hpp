@@ -0,0 +1,43 @@
+#ifndef HOST_TEST_HPP
+#define HOST_TEST_HPP
+
+// Minimal test registry for the host-side module tests (see test_main.cpp).
+// TEST() registers a function before main() runs; CHECK() records a failure
+// and carries on, so one run reports everything that broke.
+
+#include <stdio.h>
+
+typedef void (*TestFunction)();
+
+struct TestCase {
+    const char* name;
+    TestFunction run;
+    TestCase* next;
+};
+
+void testRegister(TestCase* test);
+void testFail(const char* file, int line, const char* expr);
+void testFailEq(const char* file, int line, const char* a, const char* b, long long va, long long vb);
+
+struct TestRegistrar {
+    explicit TestRegistrar(TestCase* test) { testRegister(test); }
+};
+
+#define TEST(name)                                                  \
+    static void test_##name();                                      \
+    static TestCase testCase_##name = {#name, test_##name, nullptr}; \
+    static TestRegistrar testRegistrar_##name(&testCase_##name);    \
+    static void test_##name()
+
+#define CHECK(expr)                                            \
+    do {                                                       \
+        if (!(expr)) testFail(__FILE__, __LINE__, #expr);      \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                          \
+    do {                                                                        \
+        long long va_ = (long long)(a), vb_ = (long long)(b);                   \
+        if (va_ != vb_) testFailEq(__FILE__, __LINE__, #a, #b, va_, vb_);       \
+    } while (0)
+
+#endif
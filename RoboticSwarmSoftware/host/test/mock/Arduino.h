@@ -0,0 +1,70 @@
+#ifndef HOST_TEST_ARDUINO_H
+#define HOST_TEST_ARDUINO_H
+
+// The host shim (host/shim/Arduino.h) plus the bits of the Arduino core the
+// driver modules under test use. Found first on the include path, so the
+// firmware's own #include <Arduino.h> lands here.
+
+#include_next <Arduino.h>
+
+// Serial output is dropped, tests check state rather than logs
+struct HostSerial {
+    void begin(unsigned long) {}
+    template <typename T> size_t print(const T&) { return 0; }
+    template <typename T> size_t println(const T&) { return 0; }
+    size_t println() { return 0; }
+    size_t printf(const char*, ...) { return 0; }
+};
+static HostSerial Serial __attribute__((unused));
+
+//-------------------------
+// GPIO: output levels live in mockGpio.out, like GPIO_OUT_REG (pins < 32)
+//-------------------------
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+
+struct MockGpio {
+    uint32_t out;
+    uint32_t outputs;     // Pins configured as outputs
+};
+extern MockGpio mockGpio;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+
+//-------------------------
+// Hardware timer (arduino-esp32 2.x API). Nothing fires on its own: the test
+// calls mockTimer.isr() once per period.
+//-------------------------
+typedef struct hw_timer_s hw_timer_t;
+
+struct MockTimer {
+    uint16_t divider;
+    uint64_t alarm;       // Ticks of (80 MHz / divider) between interrupts
+    bool autoreload;
+    bool enabled;
+    void (*isr)();
+};
+extern MockTimer mockTimer;
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(), bool edge);
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload);
+void timerAlarmEnable(hw_timer_t* timer);
+
+//-------------------------
+// Critical sections: the ISR runs on the test's own thread, nothing to exclude
+//-------------------------
+typedef struct {
+    int owner;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef HOST_TEST_VL53L0X_H
+#define HOST_TEST_VL53L0X_H
+
+// Pololu VL53L0X driver mock. Keeps the register-level behaviour the ToF
+// module relies on: RESULT_INTERRUPT_STATUS reads non-zero once a measurement
+// has finished, the range sits at RESULT_RANGE_STATUS + 10, and writing
+// SYSTEM_INTERRUPT_CLEAR arms the next one. Every register access checks
+// that the mux is actually routed to this sensor.
+
+#include <Arduino.h>
+#include <Wire.h>
+
+class VL53L0X {
+public:
+    enum regAddr {
+        SYSTEM_INTERRUPT_CLEAR = 0x0B,
+        RESULT_INTERRUPT_STATUS = 0x13,
+        RESULT_RANGE_STATUS = 0x14
+    };
+    enum vcselPeriodType { VcselPeriodPreRange, VcselPeriodFinalRange };
+
+    bool init(bool io_2v8 = true) {
+        (void)io_2v8;
+        access();
+        return present;
+    }
+    void setTimeout(uint16_t timeout) { (void)timeout; }
+    bool timeoutOccurred() { return false; }
+    void startContinuous(uint32_t periodMs = 0) {
+        access();
+        continuousPeriodMs = periodMs;
+    }
+    void stopContinuous() { access(); }
+    bool setSignalRateLimit(float limit) {
+        (void)limit;
+        access();
+        return true;
+    }
+    bool setMeasurementTimingBudget(uint32_t budgetUs) {
+        access();
+        timingBudgetUs = budgetUs;
+        return true;
+    }
+    bool setVcselPulsePeriod(vcselPeriodType type, uint8_t period) {
+        (void)type;
+        (void)period;
+        access();
+        return true;
+    }
+
+    uint8_t readReg(uint8_t reg) {
+        access();
+        if (reg == RESULT_INTERRUPT_STATUS) {
+            statusReads++;
+            return ready ? 0x04 : 0x00; // "New sample ready"
+        }
+        return 0;
+    }
+    uint16_t readReg16Bit(uint8_t reg) {
+        access();
+        if (reg == RESULT_RANGE_STATUS + 10) {
+            rangeReads++;
+            return range;
+        }
+        return 0;
+    }
+    void writeReg(uint8_t reg, uint8_t value) {
+        access();
+        if (reg == SYSTEM_INTERRUPT_CLEAR && value == 0x01) {
+            ready = false;
+            clears++;
+        }
+    }
+
+    // Test side
+    void mockReset(uint8_t muxChannel) {
+        channel = muxChannel;
+        present = true;
+        ready = false;
+        range = 0;
+        statusReads = rangeReads = clears = misrouted = 0;
+        continuousPeriodMs = timingBudgetUs = 0;
+    }
+    void mockMeasurement(uint16_t mm) {
+        ready = true;
+        range = mm;
+    }
+
+    uint8_t channel = 0;          // Mux channel this sensor sits behind
+    bool present = true;          // init() succeeds
+    bool ready = false;           // Measurement finished, not yet cleared
+    uint16_t range = 0;
+    uint32_t statusReads = 0;
+    uint32_t rangeReads = 0;
+    uint32_t clears = 0;
+    uint32_t misrouted = 0;       // Accesses while the mux pointed elsewhere
+    uint32_t continuousPeriodMs = 0;
+    uint32_t timingBudgetUs = 0;
+
+private:
+    void access() {
+        if (Wire.muxMask != (uint8_t)(1 << channel)) misrouted++;
+    }
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef HOST_TEST_WIRE_H
+#define HOST_TEST_WIRE_H
+
+// I2C bus mock. Only the TCA9548A mux (0x70) is modelled: the last channel
+// mask written to it is what the VL53L0X mocks see as "routed".
+
+#include <Arduino.h>
+
+#define MOCK_TCA_ADDR 0x70
+#define MOCK_MUX_NONE 0xFF   // Mux never written since mockReset()
+
+class TwoWire {
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+        (void)sda;
+        (void)scl;
+        (void)frequency;
+        return true;
+    }
+    void setClock(uint32_t frequency) { (void)frequency; }
+
+    void beginTransmission(uint8_t addr) {
+        address = addr;
+        bytes = 0;
+    }
+    size_t write(uint8_t data) {
+        if (bytes++ == 0) pending = data;
+        return 1;
+    }
+    uint8_t endTransmission(bool sendStop = true) {
+        (void)sendStop;
+        if (address == MOCK_TCA_ADDR && bytes == 1) {
+            muxMask = pending;
+            muxWrites++;
+        }
+        return 0;
+    }
+
+    // Test side
+    void mockReset() {
+        muxMask = MOCK_MUX_NONE;
+        muxWrites = 0;
+    }
+    uint8_t muxMask = MOCK_MUX_NONE;  // Channels the mux routes right now
+    uint32_t muxWrites = 0;           // Mux reprogrammings since mockReset()
+
+private:
+    uint8_t address = 0;
+    uint8_t pending = 0;
+    uint8_t bytes = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
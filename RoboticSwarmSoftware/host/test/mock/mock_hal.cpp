@@ -0,0 +1,77 @@
+// Definitions behind the mocks, and the firmware symbols the modules under
+// test call into but that belong to modules the tests don't link.
+#include <Wire.h>
+#include "soc/gpio_reg.h"
+
+#include "motor_module.hpp"
+#include "flight_recorder.hpp"
+
+TwoWire Wire;
+MockGpio mockGpio;
+MockTimer mockTimer;
+
+//-------------------------
+// GPIO
+//-------------------------
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin >= 32) return;
+    if (mode == OUTPUT) mockGpio.outputs |= 1UL << pin;
+    else mockGpio.outputs &= ~(1UL << pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin >= 32) return;
+    if (val) mockGpio.out |= 1UL << pin;
+    else mockGpio.out &= ~(1UL << pin);
+}
+
+void mockRegWrite(uint32_t reg, uint32_t value) {
+    if (reg == GPIO_OUT_W1TS_REG) mockGpio.out |= value;
+    else if (reg == GPIO_OUT_W1TC_REG) mockGpio.out &= ~value;
+}
+
+//-------------------------
+// Hardware timer
+//-------------------------
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp) {
+    (void)num;
+    (void)countUp;
+    mockTimer = MockTimer();
+    mockTimer.divider = divider;
+    return (hw_timer_t*)&mockTimer;
+}
+
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(), bool edge) {
+    (void)timer;
+    (void)edge;
+    mockTimer.isr = fn;
+}
+
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload) {
+    (void)timer;
+    mockTimer.alarm = alarmValue;
+    mockTimer.autoreload = autoreload;
+}
+
+void timerAlarmEnable(hw_timer_t* timer) {
+    (void)timer;
+    mockTimer.enabled = true;
+}
+
+//-------------------------
+// Firmware stand-ins
+//-------------------------
+
+void notifyPlanner(uint32_t events) {
+    (void)events;
+}
+
+FormationRole getFormationRole() {
+    return ROLE_NONE;
+}
+
+void recordTofFrame(const uint32_t* distances, uint8_t validMask, uint32_t frameSeq) {
+    (void)distances;
+    (void)validMask;
+    (void)frameSeq;
+}
@@ -0,0 +1,14 @@
+#ifndef HOST_TEST_GPIO_REG_H
+#define HOST_TEST_GPIO_REG_H
+
+// ESP32-S3 GPIO set/clear registers, REG_WRITE() lands in mockGpio.out
+
+#include <Arduino.h>
+
+#define GPIO_OUT_W1TS_REG 0x60004008
+#define GPIO_OUT_W1TC_REG 0x6000400C
+
+void mockRegWrite(uint32_t reg, uint32_t value);
+#define REG_WRITE(reg, val) mockRegWrite((reg), (val))
+
+#endif
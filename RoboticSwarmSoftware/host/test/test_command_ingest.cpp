@@ -0,0 +1,91 @@
+// Batched command ingest against the real ArduinoJson (native_test lib_deps):
+// the parser filter has to fit its arena on this target's pool size, or every
+// "robots" entry is silently ignored
+#include <stdio.h>
+#include <string>
+
+#include "host_test.hpp"
+#include "command_ingest.hpp"
+
+#define OWN_HOSTNAME "esp32_s3_7"
+#define OWN_ID 7
+
+static DeserializationError parse(const std::string& json, ParsedCommand* out) {
+    return parseCommand((const uint8_t*)json.data(), json.size(), out);
+}
+
+TEST(commandIngest_filterFitsItsArena) {
+    CHECK(setCommandAddress(OWN_HOSTNAME, OWN_ID));
+    CHECK(COMMAND_FILTER_BYTES > COMMAND_POOL_BYTES);
+}
+
+TEST(commandIngest_ownEntryByHostnameApplied) {
+    CHECK(setCommandAddress(OWN_HOSTNAME, OWN_ID));
+
+    ParsedCommand cmd;
+    CHECK(!parse("{\"mode\": \"LINE\", \"line_nodeDist\": 200, \"line_alignTol\": 20,"
+                 " \"robots\": {\"esp32_s3_6\": {\"line_nodeDist\": 150},"
+                 " \"" OWN_HOSTNAME "\": {\"line_nodeDist\": 250}}}", &cmd));
+    CHECK(cmd.hasMode);
+    CHECK_EQ(cmd.mode, Config::LINE);
+    CHECK(cmd.hasBatchEntry);
+    CHECK_EQ(cmd.lineNodeDist, 250);     // Own entry overrides the shared field
+    CHECK_EQ(cmd.lineAlignTol, 20);      // Shared field still applies
+}
+
+TEST(commandIngest_ownEntryByIdApplied) {
+    CHECK(setCommandAddress(OWN_HOSTNAME, OWN_ID));
+
+    ParsedCommand cmd;
+    CHECK(!parse("{\"mode\": \"POLYGON\", \"robots\": {\"6\": {\"polygon_radius\": 100},"
+                 " \"7\": {\"polygon_radius\": 350, \"polygon_alignTol\": 25}}}", &cmd));
+    CHECK(cmd.hasBatchEntry);
+    CHECK(cmd.hasPolygonRadius);
+    CHECK_EQ(cmd.polygonRadius, 350);
+    CHECK_EQ(cmd.polygonAlignTol, 25);
+}
+
+TEST(commandIngest_foreignEntriesSkipped) {
+    CHECK(setCommandAddress(OWN_HOSTNAME, OWN_ID));
+
+    ParsedCommand cmd;
+    CHECK(!parse("{\"mode\": \"IDLE\", \"robots\": {\"esp32_s3_70\": {\"idle_thresh\": 1},"
+                 " \"17\": {\"idle_thresh\": 2}, \"70\": {\"idle_thresh\": 3}}}", &cmd));
+    CHECK(cmd.hasMode);
+    CHECK_EQ(cmd.mode, Config::IDLE);
+    CHECK(!cmd.hasBatchEntry);
+    CHECK(!cmd.hasIdleThresh);
+}
+
+TEST(commandIngest_largeBatchFitsTheArena) {
+    CHECK(setCommandAddress(OWN_HOSTNAME, OWN_ID));
+
+    // 32 robots, ours last, every foreign entry scanned past
+    std::string json = "{\"mode\": \"LINE\", \"sid\": 4242, \"seq\": 9, \"robots\": {";
+    char entry[96];
+    for (int id = 1; id <= 32; id++) {
+        if (id == OWN_ID) continue;
+        snprintf(entry, sizeof(entry), "\"esp32_s3_%d\": {\"line_nodeDist\": %d, \"line_alignTol\": 5}, ", id, 100 + id);
+        json += entry;
+    }
+    json += "\"" OWN_HOSTNAME "\": {\"line_nodeDist\": 321}}}";
+
+    uint32_t failuresBefore = commandArena().failures();
+    ParsedCommand cmd;
+    CHECK(!parse(json, &cmd));
+    CHECK(cmd.hasBatchEntry);
+    CHECK_EQ(cmd.lineNodeDist, 321);
+    CHECK(!cmd.hasLineAlignTol);
+    CHECK(cmd.hasSeq);
+    CHECK_EQ(cmd.seq, 9);
+    CHECK_EQ(commandArena().failures(), failuresBefore);
+}
+
+TEST(commandIngest_manualMoveBounded) {
+    ParsedCommand cmd;
+    CHECK(!parse("{\"l\": 10000, \"r\": -5000000000, \"b\": 3000000000}", &cmd));
+    CHECK(cmd.hasManualMove);
+    CHECK_EQ(cmd.l, 10000);
+    CHECK_EQ(cmd.r, -COMMAND_MAX_MOVE_STEPS);
+    CHECK_EQ(cmd.b, COMMAND_MAX_MOVE_STEPS);
+}
@@ -0,0 +1,187 @@
+// IR frame codec: round trips, corrupted and noisy streams, decode throughput
+#include <chrono>
+#include <string.h>
+
+#include "host_test.hpp"
+#include "ir_codec.hpp"
+
+#define FUZZ_FRAMES 20000
+#define THROUGHPUT_FRAMES 200000
+
+static uint32_t fuzzState = 1;
+
+static uint32_t fuzzRandom() {
+    uint32_t x = fuzzState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return fuzzState = x;
+}
+
+// What the receiver reports for an encoded frame: the module inverts levels
+static size_t receivedFrame(const uint8_t* payload, uint8_t len, rmt_item32_t* items) {
+    size_t count = irEncodeFrame(payload, len, items, IR_MAX_FRAME_ITEMS);
+    for (size_t i = 0; i < count; i++) {
+        items[i].level0 = !items[i].level0;
+        items[i].level1 = !items[i].level1;
+    }
+    return count;
+}
+
+// Feeds items, returns the length of the last frame that completed (0 if none)
+static uint8_t feedAll(IRDecoder* dec, const rmt_item32_t* items, size_t count) {
+    uint8_t last = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t len = irDecoderFeed(dec, items[i]);
+        if (len) last = len;
+    }
+    return last;
+}
+
+static IRDecoder freshDecoder() {
+    IRDecoder dec;
+    memset(&dec, 0, sizeof(dec));
+    irDecoderReset(&dec);
+    return dec;
+}
+
+//-------------------------
+// Framing
+//-------------------------
+TEST(irCodec_roundTripEveryLength) {
+    for (uint8_t len = 1; len <= IR_MAX_PAYLOAD; len++) {
+        uint8_t payload[IR_MAX_PAYLOAD];
+        for (uint8_t i = 0; i < len; i++) payload[i] = (uint8_t)(0xA5 ^ (i * 37) ^ len);
+
+        rmt_item32_t items[IR_MAX_FRAME_ITEMS];
+        size_t count = receivedFrame(payload, len, items);
+        CHECK_EQ(count, IR_FRAME_ITEMS(len));
+
+        IRDecoder dec = freshDecoder();
+        CHECK_EQ(feedAll(&dec, items, count), len);
+        CHECK(memcmp(dec.payload, payload, len) == 0);
+        CHECK_EQ(dec.framesOk, 1);
+        CHECK_EQ(dec.framesBad, 0);
+    }
+}
+
+TEST(irCodec_encoderRejectsBadLengths) {
+    uint8_t payload[IR_MAX_PAYLOAD + 1] = {};
+    rmt_item32_t items[IR_MAX_FRAME_ITEMS];
+    CHECK_EQ(irEncodeFrame(payload, 0, items, IR_MAX_FRAME_ITEMS), 0);
+    CHECK_EQ(irEncodeFrame(payload, IR_MAX_PAYLOAD + 1, items, IR_MAX_FRAME_ITEMS), 0);
+    CHECK_EQ(irEncodeFrame(payload, 2, items, IR_FRAME_ITEMS(2) - 1), 0);
+}
+
+TEST(irCodec_backToBackFramesAllDecode) {
+    IRDecoder dec = freshDecoder();
+    for (uint8_t id = 0; id < 50; id++) {
+        uint8_t payload[2] = {id, (uint8_t)(id * 3)};
+        rmt_item32_t items[IR_MAX_FRAME_ITEMS];
+        size_t count = receivedFrame(payload, sizeof(payload), items);
+        CHECK_EQ(feedAll(&dec, items, count), 2);
+        CHECK_EQ(dec.payload[0], id);
+    }
+    CHECK_EQ(dec.framesOk, 50);
+}
+
+TEST(irCodec_startInsideBrokenFrameResynchronises) {
+    uint8_t first[2] = {1, 2};
+    uint8_t second[2] = {7, 9};
+    rmt_item32_t a[IR_MAX_FRAME_ITEMS], b[IR_MAX_FRAME_ITEMS];
+    receivedFrame(first, 2, a);
+    size_t countB = receivedFrame(second, 2, b);
+
+    // First frame cut off halfway, the second one's start pulse lands mid-byte
+    IRDecoder dec = freshDecoder();
+    CHECK_EQ(feedAll(&dec, a, 12), 0);
+    CHECK_EQ(feedAll(&dec, b, countB), 2);
+    CHECK_EQ(dec.payload[0], 7);
+    CHECK_EQ(dec.payload[1], 9);
+    CHECK_EQ(dec.framesBad, 1);
+}
+
+//-------------------------
+// Fuzz
+//-------------------------
+// Random beacons behind random garbage, a quarter of them with one item
+// damaged. Every clean frame must decode, no damaged one may decode to a
+// payload that was not sent.
+TEST(irCodec_fuzzNoisyStream) {
+    fuzzState = 12345;
+    IRDecoder dec = freshDecoder();
+    uint32_t clean = 0, cleanDecoded = 0, wrongPayloads = 0;
+
+    for (int f = 0; f < FUZZ_FRAMES; f++) {
+        uint8_t len = 1 + fuzzRandom() % IR_MAX_PAYLOAD;
+        uint8_t payload[IR_MAX_PAYLOAD];
+        for (uint8_t i = 0; i < len; i++) payload[i] = (uint8_t)fuzzRandom();
+
+        rmt_item32_t items[IR_MAX_FRAME_ITEMS];
+        size_t count = receivedFrame(payload, len, items);
+
+        bool damaged = fuzzRandom() % 4 == 0;
+        if (damaged) {
+            rmt_item32_t& item = items[fuzzRandom() % count];
+            switch (fuzzRandom() % 3) {
+                case 0: item.duration0 = fuzzRandom() % 3000; break;      // Timing glitch
+                case 1: item.duration1 = fuzzRandom() % 3000; break;
+                default:                                                  // Bit flipped
+                    item.level0 = !item.level0;
+                    item.level1 = !item.level1;
+                    break;
+            }
+        }
+
+        // Line noise between frames, whatever the receiver makes of it
+        for (uint32_t g = fuzzRandom() % 5; g > 0; g--) {
+            rmt_item32_t noise;
+            noise.val = fuzzRandom();
+            irDecoderFeed(&dec, noise);
+        }
+        irDecoderReset(&dec); // The module resets per listen slot; noise may leave a frame open
+
+        bool decoded = false;
+        for (size_t i = 0; i < count; i++) {
+            uint8_t got = irDecoderFeed(&dec, items[i]);
+            if (!got) continue;
+            if (got == len && memcmp(dec.payload, payload, len) == 0) decoded = true;
+            else wrongPayloads++;
+        }
+
+        // A damaged frame may still decode if the glitch stayed within the
+        // timing tolerance, but then it decodes to what was sent
+        if (!damaged) {
+            clean++;
+            if (decoded) cleanDecoded++;
+        }
+    }
+
+    CHECK(clean > FUZZ_FRAMES / 2);
+    CHECK_EQ(cleanDecoded, clean);
+    CHECK_EQ(wrongPayloads, 0);
+}
+
+//-------------------------
+// Throughput
+//-------------------------
+// The receiver delivers under 1000 items/s, the decoder has to be orders of
+// magnitude faster so the IR task never falls behind its ring buffer
+TEST(irCodec_decodeThroughput) {
+    uint8_t payload[2] = {0x2A, 0x13};
+    rmt_item32_t items[IR_MAX_FRAME_ITEMS];
+    size_t count = receivedFrame(payload, sizeof(payload), items);
+
+    IRDecoder dec = freshDecoder();
+    uint32_t decoded = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < THROUGHPUT_FRAMES; f++) {
+        for (size_t i = 0; i < count; i++) decoded += irDecoderFeed(&dec, items[i]) != 0;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double itemsPerS = THROUGHPUT_FRAMES * count / (seconds > 0 ? seconds : 1e-9);
+    printf("     %.1f M items/s\n", itemsPerS / 1e6);
+    CHECK_EQ(decoded, THROUGHPUT_FRAMES);
+    CHECK(itemsPerS > 1e6);
+}
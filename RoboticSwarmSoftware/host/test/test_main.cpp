@@ -0,0 +1,47 @@
+// Host-side tests for the hardware-facing firmware modules, built against the
+// mocks in host/test/mock/ (I2C bus, VL53L0X, GPIO, step timer).
+//   pio run -e native_test && .pio/build/native_test/program [TEXT]
+// Runs every test, or only those whose name contains TEXT. Exit code 1 if
+// anything failed.
+
+#include <string.h>
+
+#include "host_test.hpp"
+
+static TestCase* firstTest = nullptr;
+static TestCase* lastTest = nullptr;
+static int currentFailures = 0;
+
+void testRegister(TestCase* test) {
+    // Keep file order, it reads better in the report
+    if (lastTest) lastTest->next = test;
+    else firstTest = test;
+    lastTest = test;
+}
+
+void testFail(const char* file, int line, const char* expr) {
+    printf("    %s:%d: CHECK(%s) failed\n", file, line, expr);
+    currentFailures++;
+}
+
+void testFailEq(const char* file, int line, const char* a, const char* b, long long va, long long vb) {
+    printf("    %s:%d: %s == %s failed (%lld vs %lld)\n", file, line, a, b, va, vb);
+    currentFailures++;
+}
+
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0, failed = 0;
+
+    for (TestCase* test = firstTest; test; test = test->next) {
+        if (filter && !strstr(test->name, filter)) continue;
+        currentFailures = 0;
+        test->run();
+        run++;
+        if (currentFailures) failed++;
+        printf("%s %s\n", currentFailures ? "FAIL" : "ok  ", test->name);
+    }
+
+    printf("\n%d tests, %d failed\n", run, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+// classifyContacts() / obstacleMask(): ToF ranges fused with IR evidence
+#include "host_test.hpp"
+#include "neighbor_fusion.hpp"
+
+#define MAX_RANGE 800
+
+// One frame's worth of inputs, every direction ranged and IR silent
+struct FusionInput {
+    uint32_t distances[6];
+    uint8_t validMask;
+    uint8_t irQuality[6];
+    int16_t neighborIds[6];
+};
+
+static FusionInput quietFrame() {
+    FusionInput in;
+    for (int i = 0; i < 6; i++) {
+        in.distances[i] = 400;
+        in.irQuality[i] = 0;
+        in.neighborIds[i] = -1;
+    }
+    in.validMask = 0x3F;
+    return in;
+}
+
+static uint8_t classify(const FusionInput& in, bool irActive, ContactType* out) {
+    return classifyContacts(in.distances, in.validMask, in.irQuality, in.neighborIds, MAX_RANGE, irActive, out);
+}
+
+TEST(classifyContacts_noRangeIsNone) {
+    FusionInput in = quietFrame();
+    in.validMask = 0x3F & ~(1 << 2);    // Sensor 2 invalid
+    in.distances[4] = MAX_RANGE;        // Sensor 4 at the limit, out of reach
+    in.neighborIds[2] = 7;              // An ID alone doesn't make a contact
+    in.irQuality[4] = 255;
+
+    ContactType out[6];
+    uint8_t robots = classify(in, true, out);
+    CHECK_EQ(out[2], CONTACT_NONE);
+    CHECK_EQ(out[4], CONTACT_NONE);
+    CHECK_EQ(robots & ((1 << 2) | (1 << 4)), 0);
+}
+
+TEST(classifyContacts_idOrStrongBeaconIsRobot) {
+    FusionInput in = quietFrame();
+    in.neighborIds[0] = 3;                          // ID heard, no quality needed
+    in.irQuality[3] = CONTACT_ROBOT_QUALITY;        // Exactly at the threshold
+    in.irQuality[5] = CONTACT_ROBOT_QUALITY - 1;    // Just under, and too weak to spill over
+
+    ContactType out[6];
+    uint8_t robots = classify(in, true, out);
+    CHECK_EQ(out[0], CONTACT_ROBOT);
+    CHECK_EQ(out[3], CONTACT_ROBOT);
+    CHECK_EQ(out[5], CONTACT_UNKNOWN);
+    CHECK_EQ(robots, (1 << 0) | (1 << 3));
+}
+
+TEST(classifyContacts_adjacentBeaconCountsAtHalf) {
+    FusionInput in = quietFrame();
+    in.irQuality[1] = 2 * CONTACT_ROBOT_QUALITY;    // Spills into 0 and 2 as a robot
+
+    ContactType out[6];
+    uint8_t robots = classify(in, true, out);
+    CHECK_EQ(robots, (1 << 0) | (1 << 1) | (1 << 2));
+    CHECK_EQ(out[3], CONTACT_OBSTACLE);             // Two away, no spill
+
+    // Wraps around: sensor 5 neighbours sensor 0
+    in = quietFrame();
+    in.irQuality[5] = 2 * CONTACT_ROBOT_QUALITY;
+    robots = classify(in, true, out);
+    CHECK_EQ(robots, (1 << 4) | (1 << 5) | (1 << 0));
+
+    // Half of a mid-range beacon is neither robot nor silent
+    in = quietFrame();
+    in.irQuality[1] = CONTACT_ROBOT_QUALITY;
+    classify(in, true, out);
+    CHECK_EQ(out[0], CONTACT_UNKNOWN);
+}
+
+TEST(classifyContacts_silenceIsObstacleOnlyOnceIrActive) {
+    FusionInput in = quietFrame();
+    in.irQuality[2] = CONTACT_OBSTACLE_QUALITY;     // At the threshold, still silent
+    in.irQuality[4] = 2 * CONTACT_OBSTACLE_QUALITY + 2; // Spills just over the threshold into 3 and 5
+
+    ContactType out[6];
+    classify(in, true, out);
+    CHECK_EQ(out[0], CONTACT_OBSTACLE);
+    CHECK_EQ(out[2], CONTACT_OBSTACLE);
+    CHECK_EQ(out[3], CONTACT_UNKNOWN);
+    CHECK_EQ(out[4], CONTACT_UNKNOWN);
+    CHECK_EQ(out[5], CONTACT_UNKNOWN);
+
+    // Before the first full listen rotation silence proves nothing
+    classify(in, false, out);
+    for (int i = 0; i < 6; i++) CHECK(out[i] != CONTACT_OBSTACLE);
+}
+
+TEST(obstacleMask_onlyObstacles) {
+    ContactType contacts[6] = {CONTACT_OBSTACLE, CONTACT_ROBOT, CONTACT_NONE,
+                               CONTACT_UNKNOWN, CONTACT_OBSTACLE, CONTACT_ROBOT};
+    CHECK_EQ(obstacleMask(contacts), (1 << 0) | (1 << 4));
+
+    FusionInput in = quietFrame();
+    in.neighborIds[1] = 9;
+    ContactType out[6];
+    classify(in, true, out);
+    CHECK_EQ(obstacleMask(out), 0x3F & ~(1 << 1));  // Everything else is a silent wall
+}
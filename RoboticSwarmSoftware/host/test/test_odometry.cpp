@@ -0,0 +1,33 @@
+// Odometry heading over long runs of spinning
+#include "host_test.hpp"
+#include "odometry.hpp"
+
+#define SPIN_STEPS_PER_TURN 560   // 14 wheel steps per 9 deg
+
+// Wheel steps of a pure clockwise spin of s, as bodyToWheels() splits it
+static WheelSteps spinSteps(int32_t s) {
+    WheelSteps w;
+    w.left = s;
+    w.right = -s;
+    w.back = -s;
+    return w;
+}
+
+TEST(odometry_headingFromSpin) {
+    CHECK_EQ(wheelsToHeadingMdeg(spinSteps(0)), 0);
+    CHECK_EQ(wheelsToHeadingMdeg(spinSteps(SPIN_STEPS_PER_TURN / 4)), 270000);   // 90 deg clockwise
+    CHECK_EQ(wheelsToHeadingMdeg(spinSteps(-SPIN_STEPS_PER_TURN / 4)), 90000);
+}
+
+TEST(odometry_headingSurvivesManyTurns) {
+    // 10000 turns is past where the spin overflows int32 millidegrees
+    int32_t turns = 10000 * SPIN_STEPS_PER_TURN;
+    CHECK_EQ(wheelsToHeadingMdeg(spinSteps(turns)), 0);
+    CHECK_EQ(wheelsToHeadingMdeg(spinSteps(turns + SPIN_STEPS_PER_TURN / 4)), 270000);
+    CHECK_EQ(wheelsToHeadingMdeg(spinSteps(-turns - SPIN_STEPS_PER_TURN / 4)), 90000);
+
+    Odometry o;
+    odometryInit(&o, spinSteps(0));
+    CHECK(odometryUpdate(&o, spinSteps(turns + SPIN_STEPS_PER_TURN / 4)));
+    CHECK_EQ(o.headingMdeg, 270000);
+}
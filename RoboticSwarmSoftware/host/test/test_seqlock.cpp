@@ -0,0 +1,92 @@
+// SeqLock under a real concurrent writer and readers (std::thread)
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "host_test.hpp"
+#include "seqlock.hpp"
+
+#define STRESS_WORDS 64        // Big enough that a torn copy is likely if the lock is broken
+#define STRESS_READERS 3
+#define STRESS_MS 300
+
+// Every word holds the same generation number, a torn read mixes two
+struct StressFrame {
+    uint32_t generation[STRESS_WORDS];
+};
+
+static SeqLock<StressFrame> stressLock;
+
+TEST(seqlock_versionCountsCompletedWrites) {
+    SeqLock<StressFrame> lock;
+    StressFrame frame = {};
+
+    CHECK_EQ(lock.version(), 0);
+    lock.write(frame);
+    lock.write(frame);
+    CHECK_EQ(lock.version(), 2);
+}
+
+TEST(seqlock_readReturnsLatestWrite) {
+    SeqLock<StressFrame> lock;
+    StressFrame frame;
+    for (int i = 0; i < STRESS_WORDS; i++) frame.generation[i] = 41;
+    lock.write(frame);
+    for (int i = 0; i < STRESS_WORDS; i++) frame.generation[i] = 42;
+    lock.write(frame);
+
+    StressFrame out = {};
+    CHECK(lock.read(out));
+    CHECK_EQ(out.generation[0], 42);
+    CHECK_EQ(out.generation[STRESS_WORDS - 1], 42);
+}
+
+TEST(seqlock_concurrentReadersNeverSeeTornFrames) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> torn(0), backwards(0), reads(0), failedReads(0);
+
+    std::thread writer([&]() {
+        StressFrame frame;
+        uint32_t generation = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            generation++;
+            for (int i = 0; i < STRESS_WORDS; i++) frame.generation[i] = generation;
+            stressLock.write(frame);
+        }
+    });
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < STRESS_READERS; r++) {
+        readers.emplace_back([&]() {
+            StressFrame out = {};
+            uint32_t last = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (!stressLock.read(out)) {
+                    failedReads++; // Bounded retries ran out, out must be the previous frame
+                }
+                uint32_t g = out.generation[0];
+                for (int i = 1; i < STRESS_WORDS; i++) {
+                    if (out.generation[i] != g) {
+                        torn++;
+                        break;
+                    }
+                }
+                if (g < last) backwards++;
+                last = g;
+                reads++;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(STRESS_MS));
+    stop = true;
+    writer.join();
+    for (size_t r = 0; r < readers.size(); r++) readers[r].join();
+
+    printf("    %u reads, %u gave up and kept the old frame, %u writes\n",
+           reads.load(), failedReads.load(), stressLock.version());
+    CHECK_EQ(torn.load(), 0);
+    CHECK_EQ(backwards.load(), 0);
+    CHECK(reads.load() > failedReads.load()); // Readers made progress, not just retries
+}
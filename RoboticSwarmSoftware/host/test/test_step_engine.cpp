@@ -0,0 +1,253 @@
+// Pulse schedule of step_engine.cpp: the timer ISR is fired tick by tick and
+// the STEP/DIR pin levels it writes are logged and checked against the profile.
+#include <vector>
+
+#include "host_test.hpp"
+#include "step_engine.hpp"
+
+#define TEST_MAX_SPEED 1000   // steps/s, motor_module's MOTOR_MAX_SPEED
+#define TEST_ACCEL 4000       // steps/s^2, MOTOR_ACCEL
+#define CRUISE_TICKS (STEP_TICK_HZ / TEST_MAX_SPEED)
+#define STOP_STEPS (TEST_MAX_SPEED * TEST_MAX_SPEED / (2 * TEST_ACCEL)) // v^2 / 2a
+
+static const uint8_t STEP_PINS[STEP_AXIS_COUNT] = {5, 6, 7};
+static const uint8_t DIR_PINS[STEP_AXIS_COUNT] = {16, 17, 18};
+
+struct PulseLog {
+    std::vector<uint32_t> rise;   // Tick of every STEP rising edge
+    std::vector<int8_t> dir;      // DIR level (+1 / -1) at that edge
+    std::vector<uint32_t> dirChange;
+    uint32_t minHighTicks;        // Shortest STEP high time
+    uint32_t highSince;
+};
+
+static uint32_t tick = 0;
+static PulseLog logs[STEP_AXIS_COUNT];
+
+static void startEngine() {
+    mockGpio = MockGpio();
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        stepEngineSetLimits(i, TEST_MAX_SPEED, TEST_ACCEL);
+        logs[i] = PulseLog();
+        logs[i].minHighTicks = UINT32_MAX;
+    }
+    initStepEngine(STEP_PINS, DIR_PINS);
+    tick = 0;
+}
+
+static bool pin(uint8_t p) {
+    return (mockGpio.out >> p) & 1;
+}
+
+// Fires the ISR n times, logging edges
+static void runTicks(uint32_t n) {
+    for (uint32_t k = 0; k < n; k++) {
+        bool step[STEP_AXIS_COUNT], dir[STEP_AXIS_COUNT];
+        for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+            step[i] = pin(STEP_PINS[i]);
+            dir[i] = pin(DIR_PINS[i]);
+        }
+        mockTimer.isr();
+        tick++;
+        for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+            PulseLog& log = logs[i];
+            if (pin(DIR_PINS[i]) != dir[i]) log.dirChange.push_back(tick);
+            if (!step[i] && pin(STEP_PINS[i])) {
+                log.rise.push_back(tick);
+                log.dir.push_back(pin(DIR_PINS[i]) ? 1 : -1);
+                log.highSince = tick;
+            }
+            if (step[i] && !pin(STEP_PINS[i])) {
+                log.minHighTicks = min(log.minHighTicks, tick - log.highSince);
+            }
+        }
+    }
+}
+
+// Runs until every axis has reached its target and come to rest, returns false on timeout
+static bool runUntilIdle(uint32_t maxTicks) {
+    uint32_t end = tick + maxTicks;
+    while (tick < end) {
+        runTicks(100);
+        bool idle = true;
+        for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+            uint32_t lastRise = logs[i].rise.empty() ? 0 : logs[i].rise.back();
+            if (stepEngineDistanceToGo(i) != 0 || tick - lastRise < 2 * CRUISE_TICKS) idle = false;
+        }
+        if (idle) return true;
+    }
+    return false;
+}
+
+static uint32_t minInterval(const PulseLog& log, size_t from = 1, size_t to = SIZE_MAX) {
+    uint32_t best = UINT32_MAX;
+    for (size_t k = max<size_t>(from, 1); k < min(to, log.rise.size()); k++) {
+        best = min(best, log.rise[k] - log.rise[k - 1]);
+    }
+    return best;
+}
+
+//-------------------------
+// Tests
+//-------------------------
+TEST(stepEngine_timerRunsAtTickRate) {
+    startEngine();
+    CHECK(mockTimer.isr != nullptr);
+    CHECK(mockTimer.enabled);
+    CHECK(mockTimer.autoreload);
+    // 80 MHz APB through the divider, alarm every 1 / STEP_TICK_HZ
+    CHECK_EQ(80000000ULL / mockTimer.divider / mockTimer.alarm, STEP_TICK_HZ);
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        CHECK(mockGpio.outputs & (1UL << STEP_PINS[i]));
+        CHECK(mockGpio.outputs & (1UL << DIR_PINS[i]));
+    }
+}
+
+TEST(stepEngine_trapezoidMoveHitsTargetWithinLimits) {
+    startEngine();
+    stepEngineMove(0, 500);
+    CHECK(runUntilIdle(40000));
+
+    const PulseLog& log = logs[0];
+    CHECK_EQ(log.rise.size(), 500);
+    CHECK_EQ(stepEnginePosition(0), 500);
+    for (size_t k = 0; k < log.dir.size(); k++) CHECK_EQ(log.dir[k], 1);
+
+    // A pulse is high for one tick, and never faster than the speed limit
+    CHECK_EQ(log.minHighTicks, 1);
+    CHECK(minInterval(log) >= CRUISE_TICKS);
+
+    // 125 steps up to speed in 0.25 s, 250 at speed, 125 down: at rest 0.75 s
+    // after the move, the last step one step's worth of ramp (22 ms) before that
+    uint32_t moveTicks = log.rise.back();
+    CHECK(moveTicks >= STEP_TICK_HZ * 72 / 100);
+    CHECK(moveTicks <= STEP_TICK_HZ * 75 / 100);
+
+    // Starts and ends slow: the profile ramps, it doesn't jump to cruise speed
+    CHECK(log.rise[1] - log.rise[0] > 4 * CRUISE_TICKS);
+    CHECK(log.rise[499] - log.rise[498] > 4 * CRUISE_TICKS);
+
+    // Other axes untouched
+    CHECK(logs[1].rise.empty());
+    CHECK(logs[2].rise.empty());
+}
+
+TEST(stepEngine_accelerationStaysWithinLimit) {
+    startEngine();
+    stepEngineMove(1, 800);
+    CHECK(runUntilIdle(40000));
+
+    // From rest at constant acceleration a, step n can't come before
+    // sqrt(2n / a). Per-step intervals are too quantised to differentiate,
+    // so check the envelope over the ramp up, and mirrored over the ramp down.
+    const PulseLog& log = logs[1];
+    CHECK_EQ(log.rise.size(), 800);
+    // The last step goes out a step's worth of ramp before standstill.
+    uint32_t end = log.rise.back();
+    double lastStep = sqrt(2.0 / TEST_ACCEL) * STEP_TICK_HZ;
+    for (size_t n = 1; n <= STOP_STEPS; n++) {
+        double earliest = sqrt(2.0 * n / TEST_ACCEL) * STEP_TICK_HZ;
+        CHECK(log.rise[n - 1] >= earliest * 0.97);
+        CHECK(end - log.rise[log.rise.size() - 1 - n] >= earliest * 0.97 - lastStep);
+    }
+}
+
+TEST(stepEngine_reversalDecelsBeforeFlippingDir) {
+    startEngine();
+    stepEngineMove(0, 2000);
+    runTicks(STEP_TICK_HZ / 2); // At cruise speed
+    int32_t turnAt = stepEnginePosition(0);
+    size_t before = logs[0].rise.size();
+
+    stepEngineMove(0, -300); // Target now behind
+    CHECK(runUntilIdle(40000));
+
+    const PulseLog& log = logs[0];
+    CHECK_EQ(stepEnginePosition(0), turnAt - 300);
+    CHECK_EQ(log.dirChange.size(), 1);
+
+    // Overshoot is the stopping distance, then it comes back
+    size_t flip = before;
+    while (flip < log.dir.size() && log.dir[flip] > 0) flip++;
+    int32_t overshoot = (int32_t)(flip - before);
+    CHECK(overshoot >= STOP_STEPS - 5 && overshoot <= STOP_STEPS + 5);
+
+    // DIR set at rest, a tick ahead of the first step it governs
+    CHECK(log.rise[flip] > log.dirChange[0]);
+    CHECK(log.rise[flip] - log.rise[flip - 1] > 4 * CRUISE_TICKS);
+}
+
+TEST(stepEngine_retargetOntoPositionAtSpeedDecelerates) {
+    startEngine();
+    stepEngineMove(2, 2000);
+    runTicks(STEP_TICK_HZ / 2);
+    int32_t here = stepEnginePosition(2);
+    size_t before = logs[2].rise.size();
+
+    // setMotorSteps(0, 0, 0) on a mode change does exactly this
+    stepEngineMove(2, 0);
+    CHECK(runUntilIdle(40000));
+
+    const PulseLog& log = logs[2];
+    CHECK_EQ(stepEnginePosition(2), here);
+    // Coasted through the stopping distance instead of halting at full speed
+    CHECK((int32_t)(log.rise.size() - before) >= 2 * (STOP_STEPS - 5));
+    CHECK(minInterval(log, before) >= CRUISE_TICKS);
+}
+
+TEST(stepEngine_stopBrakesOverStoppingDistance) {
+    startEngine();
+    stepEngineMove(0, 100000);
+    runTicks(STEP_TICK_HZ / 2);
+    int32_t at = stepEnginePosition(0);
+
+    stepEngineStop(0);
+    runTicks(STEP_TICK_HZ);
+
+    int32_t braked = stepEnginePosition(0) - at;
+    CHECK(braked >= STOP_STEPS - 5 && braked <= STOP_STEPS + 5);
+    CHECK_EQ(stepEngineDistanceToGo(0), 0);
+}
+
+TEST(stepEngine_coordinatedMoveArrivesTogether) {
+    startEngine();
+    stepEngineSetTrajectoryLimits(TEST_MAX_SPEED, TEST_ACCEL, 100000);
+    const int32_t move[STEP_AXIS_COUNT] = {600, -600, 150};
+    stepEngineMoveCoordinated(move);
+    CHECK(runUntilIdle(60000));
+
+    uint32_t first = UINT32_MAX, last = 0;
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        CHECK_EQ(stepEnginePosition(i), move[i]);
+        CHECK_EQ(logs[i].rise.size(), (size_t)abs(move[i]));
+        CHECK(minInterval(logs[i]) >= CRUISE_TICKS - 1);
+        CHECK_EQ(logs[i].minHighTicks, 1);
+        first = min(first, logs[i].rise.front());
+        last = max(last, logs[i].rise.back());
+    }
+    // Straight line in wheel space: every axis is a fixed fraction of the way at any time
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        uint32_t finish = logs[i].rise.back();
+        CHECK(last - finish < STEP_TICK_HZ / 20); // Within 50 ms of each other
+    }
+    CHECK(logs[1].dir[0] == -1);
+}
+
+// Distance to go and tracking error in Q8 steps/s pass INT32_MAX beyond ~8000
+// steps; a long move must still run forward at the cap and stop on target
+TEST(stepEngine_longCoordinatedMoveReachesTarget) {
+    startEngine();
+    stepEngineSetTrajectoryLimits(TEST_MAX_SPEED, TEST_ACCEL, 100000);
+    const int32_t move[STEP_AXIS_COUNT] = {20000, -20000, 5000};
+    stepEngineMoveCoordinated(move);
+    CHECK(runUntilIdle(STEP_TICK_HZ * 25));
+
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        CHECK_EQ(stepEnginePosition(i), move[i]);
+        CHECK_EQ(logs[i].rise.size(), (size_t)abs(move[i]));
+        CHECK(logs[i].dirChange.size() <= 1);        // Set once at the start, never reversed
+        CHECK(minInterval(logs[i]) >= CRUISE_TICKS - 1);
+    }
+    CHECK(logs[0].dir.front() == 1);
+    CHECK(logs[1].dir.front() == -1);
+}
@@ -0,0 +1,255 @@
+// tof_module.cpp against the mocked TCA9548A and VL53L0X sensors
+#include <Wire.h>
+#include <VL53L0X.h>
+
+#include "host_test.hpp"
+#include "tof_module.hpp"
+
+#define TEST_SENSORS 6
+
+// tof_module.cpp internals
+extern VL53L0X sensor[TEST_SENSORS];
+extern bool sensorInitialized[TEST_SENSORS];
+bool pollDistance(uint8_t channel, uint16_t* distance);
+void tcaDeselectAll();
+
+static void resetBus() {
+    tcaDeselectAll(); // Also forgets the cached mux channel
+    Wire.mockReset();
+    for (uint8_t i = 0; i < TEST_SENSORS; i++) {
+        sensor[i].mockReset(i);
+        sensorInitialized[i] = true;
+    }
+}
+
+//-------------------------
+// pollDistance()
+//-------------------------
+TEST(pollDistance_notReadyLeavesSensorAlone) {
+    resetBus();
+    uint16_t distance = 1234;
+
+    CHECK(!pollDistance(2, &distance));
+    CHECK_EQ(distance, 1234);
+    CHECK_EQ(sensor[2].statusReads, 1);
+    CHECK_EQ(sensor[2].rangeReads, 0);
+    CHECK_EQ(sensor[2].clears, 0);
+    CHECK_EQ(sensor[2].misrouted, 0);
+}
+
+TEST(pollDistance_readyReadsAndClears) {
+    resetBus();
+    uint16_t distance = 0;
+
+    sensor[4].mockMeasurement(412);
+    CHECK(pollDistance(4, &distance));
+    CHECK_EQ(distance, 412);
+    CHECK_EQ(sensor[4].rangeReads, 1);
+    CHECK_EQ(sensor[4].clears, 1);
+
+    // Cleared, so the same measurement isn't returned twice
+    CHECK(!pollDistance(4, &distance));
+    CHECK_EQ(sensor[4].rangeReads, 1);
+    CHECK_EQ(sensor[4].misrouted, 0);
+}
+
+TEST(pollDistance_muxWrittenOnlyOnChannelChange) {
+    resetBus();
+    uint16_t distance;
+
+    pollDistance(1, &distance);
+    pollDistance(1, &distance);
+    pollDistance(1, &distance);
+    CHECK_EQ(Wire.muxWrites, 1);
+    CHECK_EQ(Wire.muxMask, 1 << 1);
+
+    pollDistance(5, &distance);
+    CHECK_EQ(Wire.muxWrites, 2);
+    CHECK_EQ(Wire.muxMask, 1 << 5);
+}
+
+TEST(pollDistance_sweepReadsEachSensorBehindItsChannel) {
+    resetBus();
+    for (uint8_t i = 0; i < TEST_SENSORS; i++) sensor[i].mockMeasurement(100 + 50 * i);
+
+    for (uint8_t i = 0; i < TEST_SENSORS; i++) {
+        uint16_t distance = 0;
+        CHECK(pollDistance(i, &distance));
+        CHECK_EQ(distance, 100 + 50 * i);
+    }
+    for (uint8_t i = 0; i < TEST_SENSORS; i++) CHECK_EQ(sensor[i].misrouted, 0);
+    CHECK_EQ(Wire.muxWrites, TEST_SENSORS);
+}
+
+TEST(pollDistance_skipsMissingSensorsWithoutBusTraffic) {
+    resetBus();
+    uint16_t distance;
+
+    sensorInitialized[3] = false;
+    sensor[3].mockMeasurement(300);
+    CHECK(!pollDistance(3, &distance));
+    CHECK(!pollDistance(TEST_SENSORS, &distance));
+    CHECK_EQ(Wire.muxWrites, 0);
+    CHECK_EQ(sensor[3].statusReads, 0);
+}
+
+//-------------------------
+// Range filter on VL53L0X-shaped traces: ±5 mm noise, 65535 timeouts, 8190
+// "no target" codes, single-sample spikes, and real range changes
+//-------------------------
+static uint16_t feed(RangeFilter* f, const uint16_t* trace, size_t n) {
+    for (size_t i = 0; i < n; i++) updateRangeFilter(f, trace[i]);
+    return rangeFilterOutput(f);
+}
+
+static bool near(uint16_t out, uint16_t expected, uint16_t tolerance) {
+    return abs((int)out - (int)expected) <= tolerance;
+}
+
+TEST(rangeFilter_locksOnAfterMajorityOfWindow) {
+    RangeFilter f;
+    resetRangeFilter(&f);
+    const uint16_t trace[] = {304, 297, 301};
+
+    updateRangeFilter(&f, trace[0]);
+    updateRangeFilter(&f, trace[1]);
+    CHECK(!f.tracking);
+    CHECK_EQ(rangeFilterOutput(&f), TOF_NO_TARGET_MM);
+
+    updateRangeFilter(&f, trace[2]);
+    CHECK(f.tracking);
+    CHECK(near(rangeFilterOutput(&f), 300, 5));
+}
+
+TEST(rangeFilter_steadyNoisyTarget) {
+    RangeFilter f;
+    resetRangeFilter(&f);
+    const uint16_t trace[] = {302, 296, 305, 299, 301, 294, 306, 300, 298, 303, 297, 301, 305, 296, 300};
+    uint16_t out = feed(&f, trace, sizeof(trace) / sizeof(trace[0]));
+    CHECK(f.tracking);
+    CHECK(near(out, 300, 4));
+}
+
+TEST(rangeFilter_coastsThroughDropouts) {
+    RangeFilter f;
+    resetRangeFilter(&f);
+    const uint16_t trace[] = {410, 407, 412, 65535, 409, 8190, 411, 0, 408, 65535, 8191, 410};
+    for (size_t i = 0; i < sizeof(trace) / sizeof(trace[0]); i++) {
+        updateRangeFilter(&f, trace[i]);
+        if (i >= 2) {
+            CHECK(f.tracking); // Never more than two misses in a row
+            CHECK(near(rangeFilterOutput(&f), 410, 6));
+        }
+    }
+}
+
+TEST(rangeFilter_rejectsSingleSpikes) {
+    RangeFilter f;
+    resetRangeFilter(&f);
+    const uint16_t trace[] = {250, 252, 249, 251, 1480, 250, 248, 1900, 251, 40, 250};
+    for (size_t i = 0; i < sizeof(trace) / sizeof(trace[0]); i++) {
+        updateRangeFilter(&f, trace[i]);
+        if (i >= 2) CHECK(near(rangeFilterOutput(&f), 250, 6));
+    }
+}
+
+TEST(rangeFilter_relocksOnPersistentStep) {
+    RangeFilter f;
+    resetRangeFilter(&f);
+    // A robot drives in between the sensor and the wall
+    const uint16_t trace[] = {900, 903, 898, 901, 899, 520, 518, 522, 519, 521, 520, 517, 523};
+    uint16_t out = feed(&f, trace, sizeof(trace) / sizeof(trace[0]));
+    CHECK(f.tracking);
+    CHECK(near(out, 520, 8));
+}
+
+TEST(rangeFilter_followsApproachingTarget) {
+    RangeFilter f;
+    resetRangeFilter(&f);
+    // Closing at 10 mm per frame (~0.5 m/s at 50 Hz), with noise
+    int worstLag = 0;
+    for (int i = 0; i < 40; i++) {
+        uint16_t truth = 700 - 10 * i;
+        uint16_t raw = truth + ((i * 7) % 9) - 4;
+        updateRangeFilter(&f, raw);
+        if (i >= 10) worstLag = max(worstLag, abs((int)rangeFilterOutput(&f) - (int)truth));
+    }
+    CHECK(f.tracking);
+    CHECK(worstLag <= 30); // Median window lags, the velocity term pulls it back
+}
+
+TEST(rangeFilter_targetLostAfterMaxMisses) {
+    RangeFilter f;
+    resetRangeFilter(&f);
+    const uint16_t trace[] = {600, 603, 598, 601};
+    feed(&f, trace, sizeof(trace) / sizeof(trace[0]));
+    CHECK(f.tracking);
+
+    for (int i = 0; i < TOF_MAX_MISSES - 1; i++) updateRangeFilter(&f, 8190);
+    CHECK(f.tracking);
+    updateRangeFilter(&f, 8190);
+    CHECK(!f.tracking);
+    CHECK_EQ(rangeFilterOutput(&f), TOF_NO_TARGET_MM);
+
+    // History dropped: a single return doesn't bring the channel back
+    updateRangeFilter(&f, 600);
+    CHECK(!f.tracking);
+}
+
+//-------------------------
+// Frame assembly
+//-------------------------
+static void lockAll(RangeFilter* filters) {
+    for (uint8_t i = 0; i < TEST_SENSORS; i++) {
+        resetRangeFilter(&filters[i]);
+        for (int k = 0; k < TOF_MEDIAN_N; k++) updateRangeFilter(&filters[i], 300 + 20 * i);
+    }
+}
+
+TEST(closeRangeFrame_allSensorsStalledGoInvalid) {
+    RangeFilter filters[TEST_SENSORS];
+    uint32_t distances[TEST_SENSORS];
+    lockAll(filters);
+    const uint8_t expected = 0x3F;
+
+    CHECK_EQ(closeRangeFrame(filters, expected, expected, distances), expected);
+
+    // Hung mux: timeout frames with nothing fresh
+    uint8_t valid = expected;
+    for (int frame = 0; frame < TOF_MAX_MISSES; frame++) {
+        valid = closeRangeFrame(filters, 0, expected, distances);
+    }
+    CHECK_EQ(valid, 0);
+    for (uint8_t i = 0; i < TEST_SENSORS; i++) CHECK_EQ(distances[i], TOF_NO_TARGET_MM);
+}
+
+TEST(closeRangeFrame_onlyStalledChannelGoesInvalid) {
+    RangeFilter filters[TEST_SENSORS];
+    uint32_t distances[TEST_SENSORS];
+    lockAll(filters);
+    const uint8_t expected = 0x3F;
+    const uint8_t fresh = expected & ~(1 << 2);
+
+    uint8_t valid = 0;
+    for (int frame = 0; frame < TOF_MAX_MISSES; frame++) {
+        for (uint8_t i = 0; i < TEST_SENSORS; i++) {
+            if (fresh & (1 << i)) updateRangeFilter(&filters[i], 300 + 20 * i);
+        }
+        valid = closeRangeFrame(filters, fresh, expected, distances);
+    }
+    CHECK_EQ(valid, fresh);
+    CHECK_EQ(distances[2], TOF_NO_TARGET_MM);
+    CHECK(near(distances[5], 400, 2));
+}
+
+TEST(closeRangeFrame_missingSensorsDontCountAsMisses) {
+    RangeFilter filters[TEST_SENSORS];
+    uint32_t distances[TEST_SENSORS];
+    lockAll(filters);
+    const uint8_t expected = 0x3F & ~(1 << 4); // Sensor 4 failed init
+
+    for (int frame = 0; frame < 2 * TOF_MAX_MISSES; frame++) {
+        closeRangeFrame(filters, expected, expected, distances);
+    }
+    CHECK(filters[4].tracking); // Never polled, never penalised
+}
@@ -0,0 +1,69 @@
+#ifndef CLOCK_SYNC_HPP
+#define CLOCK_SYNC_HPP
+
+#include <Arduino.h>
+
+//NTP-style offset estimate between this robot's esp_timer clock (local µs
+//since boot) and the swarm clock kept by the hub (Unix time in µs, see
+//GUI/clock_server.py). The robot publishes a ClockRequest on
+//clock/<hostname>/req and the hub answers with a ClockResponse on
+//clock/<hostname>/resp, both binary and little-endian:
+//  t1 robot send (local), t2 hub receive, t3 hub send (swarm), t4 robot receive (local)
+//  offset = ((t2 - t1) + (t3 - t4)) / 2,  round trip = (t4 - t1) - (t3 - t2)
+//The estimate is the sample with the shortest round trip among the last
+//CLOCK_SYNC_WINDOW, since queueing delay is what makes the two legs uneven.
+//Its error is at most half that round trip, reported as the accuracy.
+//Network task only, nothing here is shared.
+
+#define CLOCK_SYNC_VERSION 1
+#define CLOCK_SYNC_WINDOW 8
+#define CLOCK_SYNC_FAST_MS 250        // Request period until the window is full
+#define CLOCK_SYNC_INTERVAL_MS 2000   // Request period after that, well inside crystal drift
+#define CLOCK_SYNC_MAX_AGE_MS 30000   // Estimate older than this no longer counts as synced
+
+struct __attribute__((packed)) ClockRequest {
+  uint8_t  version;          // CLOCK_SYNC_VERSION
+  uint8_t  robotId;
+  uint16_t id;               // Echoed back, pairs the response with its request
+  int64_t  t1;
+};
+
+struct __attribute__((packed)) ClockResponse {
+  uint8_t  version;
+  uint8_t  robotId;
+  uint16_t id;
+  int64_t  t1;               // Echoed from the request
+  int64_t  t2;
+  int64_t  t3;
+};
+
+static_assert(sizeof(ClockRequest) == 12, "ClockRequest layout changed, update clock_server.py");
+static_assert(sizeof(ClockResponse) == 28, "ClockResponse layout changed, update clock_server.py");
+
+struct ClockSyncStats {
+  bool     synced;
+  int64_t  offsetUs;         // swarm - local
+  uint32_t accuracyUs;       // Half the round trip of the sample in use
+  uint32_t lastRoundTripUs;
+  uint32_t samples;          // Responses accepted since boot
+  uint32_t rejected;         // Stale, mismatched or malformed responses
+};
+
+//Next request to publish, stamped with localUs
+void clockSyncBuildRequest(ClockRequest* request, uint8_t robotId, int64_t localUs);
+
+//Feeds a response received at localUs. False if it was not usable.
+bool clockSyncOnResponse(const uint8_t* payload, size_t length, int64_t localUs);
+
+//Milliseconds until the next request is due
+uint32_t clockSyncRequestPeriodMs();
+
+//False until a response has been accepted, or once the estimate is too old
+bool clockSyncIsSynced(int64_t localUs);
+
+int64_t clockSyncSwarmToLocal(int64_t swarmUs);
+int64_t clockSyncLocalToSwarm(int64_t localUs);
+
+void clockSyncGetStats(ClockSyncStats* stats, int64_t localUs);
+
+#endif
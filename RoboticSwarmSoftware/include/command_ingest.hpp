@@ -0,0 +1,119 @@
+#ifndef COMMAND_INGEST_HPP
+#define COMMAND_INGEST_HPP
+
+#include <ArduinoJson.h>
+#include "globals.hpp"
+
+//Allocation-free MQTT command ingest: topic matching on the raw C string,
+//JSON parsed straight from the payload bytes into a document backed by a
+//static arena, and sender sequence numbers checked against a replay window.
+//
+//Batched commands: one broadcast can carry per-robot overrides, keyed by
+//hostname or numeric ID. Top-level fields apply to every robot, a robot's
+//own entry under "robots" overrides them:
+//  {"mode": "LINE", "line_alignTol": 20, "sid": 7, "seq": 12,
+//   "robots": {"esp32_s3_1": {"line_nodeDist": 250}, "2": {"line_nodeDist": 300}}}
+//Every other robot's entry is skipped by the parser filter, never stored.
+
+//ArduinoJson 7 takes variant slots a pool at a time, ARDUINOJSON_POOL_CAPACITY
+//slots of two pointers each: 1 KiB on the ESP32, 4 KiB on a 64-bit host. Both
+//arenas hold one pool plus the strings copied into it, so they follow the target.
+#define COMMAND_POOL_BYTES (ARDUINOJSON_POOL_CAPACITY * 2 * sizeof(void*))
+#define COMMAND_ARENA_BYTES (COMMAND_POOL_BYTES + 1536)
+#define COMMAND_FILTER_BYTES (COMMAND_POOL_BYTES + 1024)
+#define REPLAY_WINDOW_BITS 32
+#define COMMAND_MAX_MOVE_STEPS 100000   // Manual l / r / b clamped to this, 100 s at full speed
+
+enum CommandTopic {
+  TOPIC_OTHER,
+  TOPIC_BROADCAST,      // command/broadcast
+  TOPIC_INDIVIDUAL      // command/individual/<hostname>
+};
+
+enum RecorderAction : uint8_t {
+  RECORDER_NONE,
+  RECORDER_TRIGGER,     // {"recorder": "trigger"}, freeze shortly
+  RECORDER_DUMP,        // {"recorder": "dump"}, freeze now and publish
+  RECORDER_ARM          // {"recorder": "arm"}, clear and record again
+};
+
+//Bump allocator over a fixed buffer for ArduinoJson. Individual frees are
+//no-ops, reset() releases everything once the document has been cleared.
+class ArenaAllocator : public ArduinoJson::Allocator {
+public:
+  ArenaAllocator(uint8_t* buffer, size_t capacity);
+
+  void* allocate(size_t size) override;
+  void deallocate(void* ptr) override;
+  void* reallocate(void* ptr, size_t newSize) override;
+
+  void reset();
+  size_t used() const { return top; }
+  size_t highWater() const { return peak; }
+  uint32_t failures() const { return failed; }
+
+private:
+  uint8_t* buffer;
+  size_t capacity;
+  size_t top;
+  size_t last;          // Offset of the newest block, the only one that can grow in place
+  size_t peak;
+  uint32_t failed;
+};
+
+//Everything a command can carry, has* flags mark the fields present
+struct ParsedCommand {
+  bool hasMode;             Config::Mode mode;
+  bool hasNeighborMaxDist;  uint16_t neighborMaxDist;
+  bool hasIdleThresh;       uint16_t idleThresh;
+  bool hasLineNodeDist;     uint16_t lineNodeDist;
+  bool hasLineAlignTol;     uint16_t lineAlignTol;
+  bool hasPolygonSides;     uint8_t  polygonSides;
+  bool hasPolygonRadius;    uint16_t polygonRadius;
+  bool hasPolygonAlignTol;  uint16_t polygonAlignTol;
+  bool hasTelemetryHz;      uint8_t  telemetryHz;
+  bool hasPeerHz;           uint8_t  peerHz;
+  bool hasTofProfile;       uint8_t  tofProfile;   // TofProfile
+  RecorderAction recorder;
+
+  bool hasManualMove;       // Any of l / r / b non-zero
+  int32_t l, r, b;
+
+  bool hasBatchEntry;       // Batched command carried an entry for this robot
+
+  bool hasExecuteAt;        // Apply at this swarm time (Unix ms, hub clock) instead of on arrival
+  uint64_t executeAtMs;
+
+  bool hasSeq;              // Sender numbered this command ("sid" + "seq")
+  uint32_t session;
+  uint32_t seq;
+};
+
+//Anti-replay window over the last REPLAY_WINDOW_BITS sequence numbers of one
+//sender session. A new session id (sender restarted) resets the window.
+struct ReplayWindow {
+  bool primed;
+  uint32_t session;
+  uint32_t highest;
+  uint32_t seen;        // Bit n set = highest - n already accepted
+};
+
+CommandTopic matchCommandTopic(const char* topic, const char* hostname);
+
+//Hostname and ID this robot answers to in batched commands. Builds the
+//parser filter once; until called, "robots" entries are ignored. Returns
+//false if the filter did not fit its arena, batches are then ignored too.
+bool setCommandAddress(const char* hostname, uint8_t robotId);
+
+//Parses one command payload. Not reentrant: uses a single static document,
+//call from the MQTT callback only.
+DeserializationError parseCommand(const uint8_t* payload, size_t length, ParsedCommand* out);
+
+//True the first time a (session, seq) pair is seen, false for replays and
+//for anything older than the window
+bool replayWindowAccept(ReplayWindow* window, uint32_t session, uint32_t seq);
+
+//Arena usage, for diagnostics
+const ArenaAllocator& commandArena();
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef CONFIG_STORE_HPP
+#define CONFIG_STORE_HPP
+
+#include <Arduino.h>
+#include "globals.hpp"
+
+//Settings kept in NVS (Preferences namespace "swarm") so they survive reboots
+//and brown-outs: the formation Config, restored before the tasks start, and
+//the last good WiFi association (AP and channel), so a reconnect skips the
+//scan. The address always comes from DHCP.
+//Flash writes stall the cache on both cores, so only networkTask saves.
+
+#define CONFIG_STORE_VERSION 1      // Bump when Config's layout changes, older blobs are then ignored
+#define CONFIG_SAVE_SETTLE_MS 2000  // Config must be unchanged this long before it is written (flash wear)
+
+struct WifiCache {
+  uint8_t  bssid[6];
+  int32_t  channel;
+};
+
+//Returns false (out untouched) if nothing valid is stored
+bool configStoreLoad(Config* out);
+//Writes only if cfg differs from what is already stored
+void configStoreSave(const Config& cfg);
+
+bool wifiCacheLoad(WifiCache* out);
+//Writes only if the association changed
+void wifiCacheSave(const WifiCache& cache);
+void wifiCacheClear();
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef FLIGHT_RECORDER_HPP
+#define FLIGHT_RECORDER_HPP
+
+#include <Arduino.h>
+
+//Fixed-size flight recorder: ToF frames, planner decisions and motor targets
+//with microsecond timestamps, kept in a RAM ring. A trigger freezes the ring
+//a little later so the dump shows what led up to it and what followed.
+//Recording is a slot claim plus a 20-byte copy, safe from any task.
+
+#define RECORDER_RECORDS 2048           // ~40 KB, roughly 10 s of formation activity
+#define RECORDER_POST_TRIGGER 512       // Records still captured after a trigger
+#define RECORDER_CHUNK_RECORDS 32       // Records per MQTT dump message
+#define RECORDER_VERSION 1
+
+enum RecordType : uint8_t {
+  REC_EMPTY,
+  REC_TOF_FRAME,         // arg = validMask, data[0..5] = mm, data[6] = frame seq (low 16 bits)
+  REC_DECISION_SENSOR,   // arg = mode, data[0] = sensor index, -1 search, -2 in position
+  REC_DECISION_BEARING,  // arg = mode, data[0] = bearing deg, -1 search, -2 in position
+  REC_MOTOR_TARGET,      // data[0..2] = left, right, back steps
+  REC_TRIGGER            // arg = trigger source
+};
+
+struct __attribute__((packed)) FlightRecord {
+  uint32_t timeUs;
+  uint8_t  type;
+  uint8_t  arg;
+  int16_t  data[7];
+};
+
+static_assert(sizeof(FlightRecord) == 20, "FlightRecord layout changed, update RECORDER_VERSION and recorder_dump.py");
+
+//Header of every dump message on telemetry/<hostname>/recorder, followed by
+//recordCount FlightRecords, oldest first
+struct __attribute__((packed)) RecorderChunkHeader {
+  uint8_t  version;        // RECORDER_VERSION
+  uint8_t  recordSize;     // sizeof(FlightRecord)
+  uint16_t chunkIndex;
+  uint16_t chunkCount;
+  uint16_t recordCount;
+  uint32_t dumpId;         // Changes per dump, lets the host drop stale chunks
+};
+
+void recordTofFrame(const uint32_t* distances, uint8_t validMask, uint32_t frameSeq);
+void recordDecision(uint8_t mode, int result, bool isBearing);
+void recordMotorTarget(int left, int right, int back);
+
+//Freezes the ring after RECORDER_POST_TRIGGER more records
+void recorderTrigger(uint8_t source);
+//Clears the ring and starts recording again
+void recorderArm();
+bool recorderFrozen();
+
+//Dump, driven from the network task one chunk at a time. recorderStartDump()
+//freezes immediately if no trigger did, and returns the number of chunks.
+uint16_t recorderStartDump();
+//Copies chunk chunkIndex into buffer, returns its size in bytes (0 when out of range)
+size_t recorderReadChunk(uint16_t chunkIndex, uint8_t* buffer, size_t bufferSize);
+
+#define RECORDER_CHUNK_BYTES (sizeof(RecorderChunkHeader) + RECORDER_CHUNK_RECORDS * sizeof(FlightRecord))
+
+#endif
@@ -2,6 +2,7 @@
 #define GLOBALS_HPP
 
 #include <Arduino.h>
+#include "seqlock.hpp"
 
 #define I2C_SDA_PIN 10
 #define I2C_SCL_PIN 11
@@ -27,7 +28,8 @@
 #define LED_TYPE    WS2812B
 #define COLOR_ORDER GRB
 
-struct State {
+// --- Configuration, written only by the motor task (from queued network commands) ---
+struct Config {
   enum Mode {
     OFF,
     IDLE,
@@ -47,20 +49,80 @@ struct State {
   uint16_t line_alignTol;      // Distance tolerance for being "in position"
 
   // --- Polygon formation parameters ---
-  uint8_t  polygon_sides;      // Number of robots / polygon vertices
-  uint16_t polygon_radius;     // Target radius of polygon
-  uint16_t polygon_alignTol;   // Allowed deviation from perfect radius
+  uint8_t  polygon_sides;      // Number of polygon vertices, always 3: only triangles are formed
+  uint16_t polygon_radius;     // Side length: spacing between adjacent vertices (name kept for the wire format)
+  uint16_t polygon_alignTol;   // Allowed deviation from the side length
 
-  // --- Sensor data (read-only snapshot) ---
+  // --- Sensors ---
+  uint8_t  tof_profile;        // Requested ranging profile (TofProfile), 0 = auto from the formation role
+};
+
+// --- Sensor data, written only by the ToF task ---
+struct SensorFrame {
   uint32_t distances[6];       // IR / ToF readings (filled by sensor module)
+  uint32_t tof_frameSeq;       // Incremented for every complete ToF frame published
+  uint8_t  tof_validMask;      // Bit i set if distances[i] is a filtered, trusted range
+  uint8_t  tof_activeProfile;  // Ranging profile the sensors are running (TofProfile, never auto)
+  uint16_t tof_rateX10;        // Frames published per second, x10, over the last second
+};
+
+// --- Neighbour identification, written only by the IR task ---
+struct NeighborFrame {
+  int16_t  neighbor_ids[6];    // Robot ID heard per direction (same index as distances), -1 if none
+  uint8_t  neighbor_roles[6];  // FormationRole that neighbour announced, ROLE_NONE if none
+  uint8_t  ir_quality[6];      // IR detection quality per direction, 0 (nothing) .. 255 (clean frames)
+  uint32_t ir_cycleSeq;        // Incremented every TDMA cycle
+};
+
+// --- Dead-reckoned pose (see odometry.hpp), written only by the motor task ---
+struct PoseFrame {
+  int32_t  pose_x;             // mm from where the robot powered on, in its power-on body frame
+  int32_t  pose_y;             // mm, +y is 90 deg counter-clockwise of ToF sensor 0
+  int16_t  pose_heading;       // Body x (sensor 0) in tenths of a degree, counter-clockwise, 0..3599
+  uint32_t pose_seq;           // Incremented whenever the pose changes
 };
 
+// Read-only snapshot handed to the formation logic
+struct State : Config, SensorFrame, NeighborFrame, PoseFrame {};
+
+// --- Peer states heard over UDP multicast, written only by the network task ---
+#define PEER_TABLE_SIZE 8
+
+struct PeerEntry {
+  uint8_t  robotId;
+  uint8_t  mode;               // Peer's Config::Mode
+  uint8_t  role;               // Peer's FormationRole
+  uint8_t  tof_validMask;
+  uint16_t distances[6];       // Peer's filtered ToF ranges, mm
+  uint16_t seq;                // Last packet sequence number
+  uint16_t lost;               // Packets missed, counted from sequence gaps
+  uint32_t lastHeardMs;
+  uint32_t timeoutMs;          // Dropped when silent this long, derived from the peer's rate
+};
+
+struct PeerFrame {
+  PeerEntry peers[PEER_TABLE_SIZE]; // First count entries are valid, no particular order
+  uint8_t  count;
+};
+
+// --- Swarm clock estimate (see clock_sync.hpp), written only by the network task ---
+struct ClockFrame {
+  bool     clock_synced;       // False until the hub has answered, or once the estimate is stale
+  int64_t  clock_offsetUs;     // swarm - local (esp_timer) clock
+  uint32_t clock_accuracyUs;   // Worst-case error of the offset, half the round trip it came from
+};
 
-extern State state;
+extern SeqLock<Config> configLock;
+extern SeqLock<SensorFrame> sensorLock;
+extern SeqLock<NeighborFrame> neighborLock;
+extern SeqLock<PeerFrame> peerLock;
+extern SeqLock<PoseFrame> poseLock;
+extern SeqLock<ClockFrame> clockLock;
 extern int tof_ch_order[6];
 extern int ir_ch_order[6];
 
-// FreeRTOS Mutex
-extern SemaphoreHandle_t stateMutex;
+// Refreshes out with the latest config, sensor, neighbour and pose frames. Never
+// blocks; a part whose writer is mid-update keeps its previous contents.
+void snapshotState(State& out);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,47 @@
+#ifndef IR_CODEC_HPP
+#define IR_CODEC_HPP
+
+#include <Arduino.h>
+#include "driver/rmt.h"
+
+//IR frame: start pulse, length byte, payload bytes, CRC-8 (poly 0x07) over
+//length + payload. Bits are sent LSB first as one RMT item each (two 560us
+//halves), start pulse is 2000us mark + 1000us space.
+//The receiver module inverts levels, so the decoder expects the opposite
+//polarity to what the encoder emits.
+
+#define IR_MAX_PAYLOAD 8
+#define IR_MAX_FRAME_ITEMS (1 + (IR_MAX_PAYLOAD + 2) * 8)
+
+//On-air time of a frame carrying len payload bytes, in microseconds
+#define IR_FRAME_US(len) (3000 + ((len) + 2) * 8 * 1120)
+#define IR_FRAME_ITEMS(len) (1 + ((len) + 2) * 8)
+
+//Incremental decoder, keeps its state between RMT ring buffer chunks
+struct IRDecoder {
+  enum Phase : uint8_t { HUNT, LENGTH, PAYLOAD, CHECKSUM } phase;
+  uint8_t bitCount;
+  uint8_t current;                // Byte being assembled
+  uint8_t length;                 // Payload length from the frame header
+  uint8_t index;                  // Payload bytes received so far
+  uint8_t crc;                    // Running CRC over length + payload
+  uint8_t payload[IR_MAX_PAYLOAD];
+  uint32_t framesOk;
+  uint32_t framesBad;             // CRC failures, bad lengths and broken bits
+  uint32_t itemsIntact;           // Items with valid start / bit timing, frame or not
+};
+
+void irDecoderReset(IRDecoder* dec);
+
+//Consume one received item. Returns the payload length once a CRC-valid
+//frame completes on this item (payload is in dec->payload), 0 otherwise.
+//Any malformed item drops the partial frame and the decoder hunts for the
+//next start pulse, re-checking the same item.
+uint8_t irDecoderFeed(IRDecoder* dec, const rmt_item32_t& item);
+
+//Builds the TX items for a frame, returns the item count (0 if it does not fit)
+size_t irEncodeFrame(const uint8_t* payload, uint8_t len, rmt_item32_t* items, size_t maxItems);
+
+uint8_t irCrc8(uint8_t crc, uint8_t data);
+
+#endif
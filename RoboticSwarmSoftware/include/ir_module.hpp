@@ -1,5 +1,5 @@
 #ifndef IR_MODULE_HPP
-#define IR_MODUE_HPP
+#define IR_MODULE_HPP
 
 #include <Arduino.h>
 #include <Wire.h>
@@ -0,0 +1,53 @@
+#ifndef KINEMATICS_HPP
+#define KINEMATICS_HPP
+
+#include <Arduino.h>
+
+//Inverse kinematics for the three-wheel omni base, all in fixed point.
+//Body frame: x points at ToF sensor 0, bearings grow in sensor index order
+//(sensor i sits at i * 60 deg), omega is a clockwise spin in degrees.
+//Wheel values use the setMotorSteps() convention (left, right, back).
+
+#define Q15_ONE 32767
+
+struct WheelSteps {
+  int32_t left;
+  int32_t right;
+  int32_t back;
+};
+
+struct BodyMotion {
+  int32_t vx;
+  int32_t vy;
+  int32_t spinMdeg;  //Clockwise, millidegrees
+};
+
+//Q15 sine / cosine from a precomputed quarter-wave table, any integer angle
+int16_t sinDeg(int32_t deg);
+int16_t cosDeg(int32_t deg);
+
+//Q15 sine / cosine in millidegrees, linear between the table entries
+int16_t sinMilliDeg(int32_t mdeg);
+int16_t cosMilliDeg(int32_t mdeg);
+
+//Angle of the vector (x, y) in whole degrees, 0..359, same table (0 for a zero vector)
+int32_t atan2Deg(int32_t y, int32_t x);
+
+//Planar displacement (or velocity) plus spin -> coordinated wheel steps (or speeds)
+WheelSteps bodyToWheels(int32_t vx, int32_t vy, int32_t omegaDeg);
+
+//Same, with the translation given as a bearing and magnitude.
+//bearingToWheels(i * 60, s, 0) reproduces the old per-sensor moves (+-s per wheel).
+WheelSteps bearingToWheels(int32_t bearingDeg, int32_t magnitude, int32_t omegaDeg);
+
+//Forward kinematics, inverse of bodyToWheels(). The translation is scaled by
+//unitsPerStep before rounding (e.g. micrometres per step) so small wheel
+//deltas keep their fractions.
+BodyMotion wheelsToBody(const WheelSteps& w, int32_t unitsPerStep);
+
+//Counter-clockwise heading the spin in w ends at, millidegrees 0..359999.
+//Reduced before narrowing, so it holds however many turns w adds up to
+//(wheelsToBody()'s spinMdeg overflows after ~6000).
+int32_t wheelsToHeadingMdeg(const WheelSteps& w);
+
+#endif
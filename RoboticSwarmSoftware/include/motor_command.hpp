@@ -0,0 +1,26 @@
+#ifndef MOTOR_COMMAND_HPP
+#define MOTOR_COMMAND_HPP
+
+#include <Arduino.h>
+#include "command_ingest.hpp"
+
+//Commands from the network task, applied by motorTask at the top of its next tick.
+//Kept out of motor_module.hpp so the motor API doesn't drag ArduinoJson into
+//every includer (host tools, status payload, ToF task).
+struct MotorCommand {
+  enum Type : uint8_t {
+    CONFIG,   // Apply the present fields of config to the shared Config
+    MOVE      // Manual relative wheel move, only honoured in MANUAL mode
+  } type;
+  ParsedCommand config;
+  int32_t left, right, back;
+  int64_t executeAtUs;  // esp_timer time to apply at, 0 = as soon as dequeued
+};
+
+#define MOTOR_COMMAND_QUEUE_LEN 16
+#define MOTOR_SCHEDULED_LEN 8   // Commands held for a later execute time
+
+//Network task only (single producer). False if the queue was full and the command dropped.
+bool enqueueMotorCommand(const MotorCommand& cmd);
+
+#endif
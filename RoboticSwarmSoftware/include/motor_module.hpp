@@ -3,15 +3,57 @@
 
 #include <Arduino.h>
 #include "globals.hpp"
+#include "polar_map.hpp"
 
 void initMotors(uint8_t step1, uint8_t step2, uint8_t step3, uint8_t dir1, uint8_t dir2, uint8_t dir3);
 
 //Emergency Stop
 void stopMotors();
 
-//For override manual controls from hub
+//Sets wheel targets directly. Motor task only, other tasks go through the command queue
+//(enqueueMotorCommand() in motor_command.hpp).
 void setMotorSteps(int leftSteps, int rightSteps, int backSteps);
 
+//Queue depth right now, deepest it has been, and commands dropped because it was full
+void getCommandQueueStats(uint32_t* depth, uint32_t* maxDepth, uint32_t* dropped);
+
+//Scheduled commands: held right now, applied so far, and how late the last and
+//the worst one was applied after its execute time (µs, 1 ms tick granularity)
+void getScheduleStats(uint32_t* held, uint32_t* applied, uint32_t* lastLateUs, uint32_t* maxLateUs);
+
+//One formation planner step on a state snapshot, called by motorTask on new data.
+//map is the planner's polar range map, fed here with every new ToF frame.
+void handleMotors(State *state, int stepsToScoot, PolarMap* map);
+
+//Per-mode decisions behind handleMotors(), also used by the host benchmarks.
+//Sensor index or bearing in degrees; -1 = search, -2 = in position.
+//Without a polar map (nullptr) neighbours sit on the sensor axes.
+uint8_t getSensorMask_Idle(State* state);
+int getBestMoveDirection_Idle(uint8_t blockedMask);
+int getBestMoveBearing_Idle(uint8_t blockedMask);
+int getBestMoveDirection_Line(State* state);
+int getBestMoveBearing_Polygon(State* state, const PolarMap* map);
+
+//What the formation planner is doing, shared with peers over UDP
+enum FormationRole : uint8_t {
+  ROLE_NONE,          // OFF / MANUAL, no formation running
+  ROLE_SEARCHING,     // No neighbours, spinning to find some
+  ROLE_MOVING,        // Moving towards its place
+  ROLE_IN_POSITION    // Holding position
+};
+
+//Role from the latest planner run
+FormationRole getFormationRole();
+
+//Planner wake-up events, sent by the tasks that publish new data
+#define PLANNER_EVENT_SENSOR (1 << 0)   // New ToF frame
+#define PLANNER_EVENT_CONFIG (1 << 1)   // Mode / formation parameters changed
+
+void notifyPlanner(uint32_t events);
+
+//Number of planner runs, and motor ticks where no new data meant no run was needed
+void getPlannerStats(uint32_t* runs, uint32_t* saved);
+
 // FreeRTOS Task
 void motorTask(void* parameter);
 
@@ -0,0 +1,30 @@
+#ifndef NEIGHBOR_FUSION_HPP
+#define NEIGHBOR_FUSION_HPP
+
+#include <Arduino.h>
+
+//Fuses ToF ranges with IR detection quality into per-direction contacts.
+//A ToF return only says "something is there"; IR light from a beacon says
+//it's a robot. Directions use the distances[] index.
+
+enum ContactType : uint8_t {
+  CONTACT_NONE,      // No valid range inside maxRange
+  CONTACT_OBSTACLE,  // Ranged, IR active but silent from that side
+  CONTACT_ROBOT,     // Ranged and beacon light seen (or an ID heard)
+  CONTACT_UNKNOWN    // Ranged, not enough IR evidence either way
+};
+
+#define CONTACT_ROBOT_QUALITY    96  // ir_quality at or above this is a robot
+#define CONTACT_OBSTACLE_QUALITY 16  // ir_quality at or below this is silent
+#define CONTACT_IR_WARMUP_CYCLES 6   // Full listen rotation before silence means anything
+
+//Classifies every direction into out[6], returns a bitmask of CONTACT_ROBOT directions.
+//A beacon seen from an adjacent direction counts at half quality, since a robot
+//sitting between two sensors lights both IR receivers weakly.
+uint8_t classifyContacts(const uint32_t* distances, uint8_t validMask, const uint8_t* irQuality,
+                         const int16_t* neighborIds, uint32_t maxRange, bool irActive, ContactType* out);
+
+//Bitmask of CONTACT_OBSTACLE directions, for planners that only track robots
+uint8_t obstacleMask(const ContactType* contacts);
+
+#endif
@@ -1,11 +1,17 @@
 #ifndef NETWORK_MODULE_HPP
 #define NETWORK_MODULE_HPP
 
-void connectToHub();
+#include <Arduino.h>
+
+//Non-blocking, networkTask brings up OTA and MQTT once associated
+void startWiFi();
 void setupOTA();
 
 void setupServer();
 
+//Numeric robot ID, taken from the trailing digits of the hostname
+uint8_t getRobotId();
+
 //FreeRTOS Task
 void networkTask(void* parameter);
 
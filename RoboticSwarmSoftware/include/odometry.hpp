@@ -0,0 +1,28 @@
+#ifndef ODOMETRY_HPP
+#define ODOMETRY_HPP
+
+#include <Arduino.h>
+#include "kinematics.hpp"
+
+//Dead reckoning from the steps the wheels actually took. The world frame is
+//the body frame at odometryInit(): x at ToF sensor 0, y 90 deg counter-
+//clockwise from it, heading counter-clockwise. There is no slip model, so
+//the position drifts with distance travelled and spinning.
+
+#define ODOM_UM_PER_STEP 628   // 40 mm wheel, 200 steps/rev
+
+struct Odometry {
+  WheelSteps origin;     // Wheel positions at init, the heading comes from the total since
+  WheelSteps last;       // Wheel positions at the previous update
+  int32_t xUm;
+  int32_t yUm;
+  int32_t headingMdeg;   // 0..359999
+};
+
+//wheels in the setMotorSteps() convention (left, right, back)
+void odometryInit(Odometry* o, const WheelSteps& wheels);
+
+//Integrates the wheel travel since the last call, true if the pose moved
+bool odometryUpdate(Odometry* o, const WheelSteps& wheels);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef PEER_LINK_HPP
+#define PEER_LINK_HPP
+
+#include <Arduino.h>
+#include "globals.hpp"
+
+//Robot-to-robot state sharing, no hub involved. Every robot multicasts a
+//small PeerPacket on the LAN and keeps a bounded table of what it hears
+//(PeerFrame, published through peerLock). This file is only the packet
+//format and the table; the sockets live in network_module.cpp (WiFiUDP)
+//and host/peer/ (POSIX, for loopback tests).
+
+#define PEER_MAGIC 0x5753           // "SW", little-endian
+#define PEER_VERSION 1
+#define PEER_GROUP_IP 239, 255, 42, 1
+#define PEER_PORT 4210
+#define PEER_DEFAULT_HZ 5
+#define PEER_MAX_HZ 20
+#define PEER_TIMEOUT_PERIODS 4      // Peer dropped after this many silent send periods
+#define PEER_MIN_TIMEOUT_MS 500
+
+struct __attribute__((packed)) PeerPacket {
+  uint16_t magic;            // PEER_MAGIC
+  uint8_t  version;          // PEER_VERSION
+  uint8_t  robotId;
+  uint8_t  mode;             // Config::Mode
+  uint8_t  role;             // FormationRole
+  uint8_t  tofValidMask;
+  uint8_t  hz;               // Sender's rate, receivers derive the timeout from it
+  uint16_t seq;
+  uint16_t distances[6];     // mm, same index as State::distances
+};
+
+static_assert(sizeof(PeerPacket) == 22, "PeerPacket layout changed, bump PEER_VERSION");
+
+void buildPeerPacket(PeerPacket* packet, const State& state, uint8_t robotId, uint8_t role, uint8_t hz, uint16_t seq);
+
+//False for anything that is not a current-version PeerPacket
+bool parsePeerPacket(const uint8_t* data, size_t length, PeerPacket* out);
+
+//Adds or refreshes the sender's entry. A full table evicts the peer heard
+//from least recently.
+void peerTableUpdate(PeerFrame* table, const PeerPacket& packet, uint32_t nowMs);
+
+//Drops peers that went silent, returns how many were removed
+uint8_t peerTableAge(PeerFrame* table, uint32_t nowMs);
+
+//nullptr if robotId is not in the table
+const PeerEntry* peerTableFind(const PeerFrame& table, uint8_t robotId);
+
+#endif
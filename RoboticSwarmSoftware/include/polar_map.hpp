@@ -0,0 +1,51 @@
+#ifndef POLAR_MAP_HPP
+#define POLAR_MAP_HPP
+
+#include <Arduino.h>
+
+//360 deg range histogram built up from ToF frames while the robot turns.
+//Six sensors 60 deg apart miss robots sitting between sectors; tagging each
+//sample with the odometry heading lets a spin sweep them into fine world-
+//frame bins, and the hits on a robot cluster around its true bearing.
+//Bins fade every frame so the map follows robots that move (or us moving).
+
+#define POLAR_BIN_DEG 5
+#define POLAR_BINS (360 / POLAR_BIN_DEG)
+#define POLAR_MAX_CONTACTS 8
+
+#define POLAR_HIT_WEIGHT 64    // Added per frame a sensor ranges a robot in the bin
+#define POLAR_DECAY_SHIFT 4    // Every frame loses 1/16 of its weight, ~220 ms half-life at 50 Hz
+#define POLAR_MIN_WEIGHT 24    // Weaker bins don't make contacts
+#define POLAR_RANGE_GAP 100    // mm, neighbouring bins further apart than this are different robots
+
+struct PolarBin {
+  uint16_t range;    // mm, smoothed over the hits
+  uint8_t  weight;   // Evidence, 0 = empty
+  uint8_t  unused;
+};
+
+struct PolarMap {
+  PolarBin bins[POLAR_BINS];   // Bin b covers world bearings b * POLAR_BIN_DEG .. + POLAR_BIN_DEG
+  uint32_t frameSeq;           // tof_frameSeq of the last frame added
+};
+
+//A run of neighbouring bins on the same robot
+struct PolarContact {
+  int16_t  bearing;   // World bearing in tenths of a degree, counter-clockwise, 0..3599
+  uint16_t range;     // mm, from the strongest bin
+  uint8_t  weight;    // Strongest bin's weight
+  uint8_t  bins;      // Angular width in bins
+};
+
+void polarMapInit(PolarMap* map);
+
+//Ages the map one frame, then adds it. Sensor i looks along headingDeci + i * 600
+//(tenths of a degree). Channels in targetMask closer than maxRange are hits,
+//every other channel saw through its bin and halves it.
+void polarMapAddFrame(PolarMap* map, const uint32_t* distances, uint8_t targetMask,
+                      int16_t headingDeci, uint32_t maxRange);
+
+//Contacts in angular order, returns how many were written to out
+uint8_t polarMapContacts(const PolarMap* map, PolarContact* out, uint8_t maxOut);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <Arduino.h>
+#include <atomic>
+
+// Single-writer / multi-reader sequence lock.
+// The writer never waits: it bumps the sequence to odd, copies the value in
+// and bumps it back to even. Readers copy the value out and retry if the
+// sequence changed underneath them. Reads are bounded so a reader that
+// preempted the writer on the same core gives up instead of spinning, and
+// keeps whatever snapshot it already had.
+// T must be trivially copyable (plain structs of integers/arrays).
+template <typename T>
+class SeqLock {
+public:
+  static const int MAX_READ_ATTEMPTS = 8;
+
+  SeqLock() : seq(0), data() {}
+
+  // Publish a new value. Must only ever be called from one task.
+  void write(const T& value) {
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memcpy(&data, &value, sizeof(T));
+
+    std::atomic_thread_fence(std::memory_order_release);
+    seq.store(s + 2, std::memory_order_release);
+  }
+
+  // Copy out the latest consistent value. Returns false and leaves out
+  // untouched if every attempt overlapped a write.
+  bool read(T& out) const {
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+      uint32_t before = seq.load(std::memory_order_acquire);
+      if (before & 1) continue; // Write in progress
+
+      T copy;
+      memcpy(&copy, &data, sizeof(T));
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq.load(std::memory_order_relaxed) == before) {
+        out = copy;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Number of completed writes, cheap way for readers to detect new data
+  uint32_t version() const {
+    return seq.load(std::memory_order_acquire) >> 1;
+  }
+
+private:
+  std::atomic<uint32_t> seq;
+  T data;
+};
+
+#endif
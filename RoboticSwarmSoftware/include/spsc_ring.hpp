@@ -0,0 +1,62 @@
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <Arduino.h>
+#include <atomic>
+
+// Single-producer / single-consumer ring buffer, lock-free.
+// The producer only writes head, the consumer only writes tail, so neither
+// side ever waits on the other. A full ring rejects the push (counted as a
+// drop) rather than overwriting something the consumer has not seen yet.
+// N must be a power of two; T must be trivially copyable.
+template <typename T, uint32_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+  SpscRing() : head(0), tail(0), dropped(0), highWater(0) {}
+
+  // Producer side. Returns false if the ring is full.
+  bool push(const T& item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t depth = h - tail.load(std::memory_order_acquire);
+    if (depth >= N) {
+      dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    slots[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+
+    if (depth + 1 > highWater.load(std::memory_order_relaxed)) {
+      highWater.store(depth + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // Consumer side. Returns false if the ring is empty.
+  bool pop(T& out) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+
+    out = slots[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Safe from any task, a momentary value
+  uint32_t depth() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+  uint32_t dropCount() const { return dropped.load(std::memory_order_relaxed); }
+  uint32_t maxDepth() const { return highWater.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint32_t> head;       // Next slot to fill, producer owned
+  std::atomic<uint32_t> tail;       // Next slot to drain, consumer owned
+  std::atomic<uint32_t> dropped;    // Producer owned
+  std::atomic<uint32_t> highWater;  // Producer owned
+  T slots[N];
+};
+
+#endif
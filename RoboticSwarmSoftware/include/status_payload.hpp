@@ -0,0 +1,15 @@
+#ifndef STATUS_PAYLOAD_HPP
+#define STATUS_PAYLOAD_HPP
+
+#include <Arduino.h>
+
+//JSON bodies for the periodic MQTT reports, kept free of WiFi/MQTT so the
+//host benchmarks can build them too
+
+//telemetry/<hostname>/status, 1 Hz: mode, parameters, sensors, planner and queue counters
+void buildStatusPayload(char* buffer, size_t bufferSize);
+
+//telemetry/<hostname>/stats, 5 s: latency histograms and stack high-water marks
+void buildStatsPayload(char* buffer, size_t bufferSize);
+
+#endif
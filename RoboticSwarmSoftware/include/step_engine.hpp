@@ -0,0 +1,35 @@
+#ifndef STEP_ENGINE_HPP
+#define STEP_ENGINE_HPP
+
+#include <Arduino.h>
+
+#define STEP_AXIS_COUNT 3
+#define STEP_TICK_HZ 20000   // Step ISR rate, max step rate is half of this
+
+//Hardware-timer driven STEP/DIR generator, replaces polled AccelStepper::run().
+//Every axis runs its own trapezoidal profile inside the timer ISR, so step
+//timing no longer depends on when motorTask gets scheduled.
+void initStepEngine(const uint8_t stepPins[STEP_AXIS_COUNT], const uint8_t dirPins[STEP_AXIS_COUNT]);
+
+//Speed in steps/s, acceleration in steps/s^2
+void stepEngineSetLimits(uint8_t axis, uint32_t maxSpeed, uint32_t accel);
+
+//Same semantics as AccelStepper::move(), target relative to current position
+void stepEngineMove(uint8_t axis, int32_t relative);
+
+//Decelerate to rest as fast as the acceleration limit allows
+void stepEngineStop(uint8_t axis);
+
+//Coordinated mode: all three axes on one jerk-limited trajectory (see
+//trajectory.hpp), planned inside the step ISR at TRAJ_UPDATE_HZ. A move
+//blends with the one in progress instead of restarting the profile. Any
+//per-axis stepEngineMove() switches back to independent profiles. An
+//all-zero move holds the current position, a stop brakes along the line.
+void stepEngineSetTrajectoryLimits(uint32_t maxSpeed, uint32_t accel, uint32_t jerk);
+void stepEngineMoveCoordinated(const int32_t relative[STEP_AXIS_COUNT]);
+void stepEngineStopCoordinated();
+
+int32_t stepEnginePosition(uint8_t axis);
+int32_t stepEngineDistanceToGo(uint8_t axis);
+
+#endif
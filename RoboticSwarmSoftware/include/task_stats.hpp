@@ -0,0 +1,53 @@
+#ifndef TASK_STATS_HPP
+#define TASK_STATS_HPP
+
+#include <Arduino.h>
+
+//Lightweight timing instrumentation: CPU cycle counter deltas binned into
+//log2 histograms, plus task stack high-water marks. Each probe has exactly
+//one writer (a task or the step ISR) and is measured on that writer's core,
+//so recording is two loads and two stores, no locks.
+
+enum LatencyProbe : uint8_t {
+  PROBE_MOTOR_PERIOD,    // motorTask wake to wake, target 1 ms
+  PROBE_MOTOR_PLANNER,   // Snapshot + handleMotors on a planner run
+  PROBE_MOTOR_SNAPSHOT,  // snapshotState() alone, the seqlock read side
+  PROBE_STEP_ISR,        // Step engine tick, inside its spinlock
+  PROBE_TOF_FRAME,       // ToF frame start to publish
+  PROBE_IR_LOOP,         // IRsensorTask loop body
+  PROBE_NET_LOOP,        // networkTask loop body (MQTT, OTA, publishing)
+  PROBE_COUNT
+};
+
+#define LATENCY_BUCKETS 32   // Bucket b counts durations of 2^b .. 2^(b+1)-1 cycles
+#define TASK_STATS_MAX_TASKS 6
+
+struct LatencyHistogram {
+  uint32_t count;
+  uint32_t maxCycles;
+  uint32_t buckets[LATENCY_BUCKETS];
+};
+
+extern LatencyHistogram latencyHistograms[PROBE_COUNT];
+
+static inline __attribute__((always_inline)) uint32_t cycleCount() {
+  return ESP.getCycleCount();
+}
+
+//Bins a duration in CPU cycles. Safe from the step ISR (inlined, DRAM data).
+static inline __attribute__((always_inline)) void latencyRecord(LatencyProbe probe, uint32_t cycles) {
+  LatencyHistogram& h = latencyHistograms[probe];
+  h.buckets[31 - __builtin_clz(cycles | 1)]++;
+  if (cycles > h.maxCycles) h.maxCycles = cycles;
+  h.count++;
+}
+
+const char* latencyProbeName(LatencyProbe probe);
+
+//Tasks whose stack high-water marks are reported
+void taskStatsRegister(TaskHandle_t task, const char* name, uint32_t stackBytes);
+uint8_t taskStatsTaskCount();
+//Name, configured stack size, and the fewest bytes ever left free on it
+void taskStatsGetTask(uint8_t index, const char** name, uint32_t* stackBytes, uint32_t* minFreeBytes);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef TELEMETRY_FRAME_HPP
+#define TELEMETRY_FRAME_HPP
+
+#include <Arduino.h>
+#include "globals.hpp"
+
+//Compact binary telemetry, published on telemetry/<hostname>/bin.
+//Little-endian, packed, no allocation. Bump TELEMETRY_VERSION whenever the
+//layout changes and keep GUI/telemetry.py in step.
+
+#define TELEMETRY_VERSION 2
+#define TELEMETRY_MAX_HZ 50
+#define TELEMETRY_NO_NEIGHBOR 0xFF   // neighborIds entry with no robot heard, never a valid IR ID
+
+struct __attribute__((packed)) TelemetryFrame {
+  uint8_t  version;          // TELEMETRY_VERSION
+  uint8_t  robotId;
+  uint8_t  mode;             // Config::Mode
+  uint8_t  tofValidMask;
+  uint32_t seq;              // Telemetry frame counter, gaps = dropped frames
+  uint32_t timeMs;           // millis() when the snapshot was taken
+  uint32_t tofFrameSeq;
+  uint32_t irCycleSeq;
+  uint32_t plannerRuns;
+  uint32_t plannerSaved;
+  uint16_t neighborMaxDist;
+  uint16_t idleThresh;
+  uint16_t lineNodeDist;
+  uint16_t lineAlignTol;
+  uint16_t polygonRadius;
+  uint16_t polygonAlignTol;
+  uint8_t  polygonSides;
+  uint8_t  reserved;
+  uint16_t distances[6];     // mm, same index as State::distances
+  uint8_t  neighborIds[6];   // TELEMETRY_NO_NEIGHBOR = none (v1 was int8_t, -1 = none)
+  uint8_t  irQuality[6];
+};
+
+static_assert(sizeof(TelemetryFrame) == 66, "TelemetryFrame layout changed, update TELEMETRY_VERSION and telemetry.py");
+
+//Fills frame from a state snapshot
+void buildTelemetryFrame(TelemetryFrame* frame, const State& state, uint8_t robotId, uint32_t seq,
+                         uint32_t timeMs, uint32_t plannerRuns, uint32_t plannerSaved);
+
+#endif
@@ -4,6 +4,39 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#define TOF_NO_TARGET_MM 8190   // Published for channels without a valid range (sensor's own out-of-range code)
+
+//-----------------------------------------
+// Per-channel range filter
+// Raw readings are gated (timeouts, out-of-range codes), smoothed by a
+// median-of-N window and tracked by an integer alpha-beta filter.
+#define TOF_MEDIAN_N 5
+#define TOF_MAX_VALID_MM 2000   // Anything above is out of range for the VL53L0X
+#define TOF_MAX_MISSES 3        // Consecutive rejected/missing samples before the channel goes invalid
+#define TOF_GATE_MM 250         // Residual beyond which a sample is treated as an outlier
+#define TOF_MAX_GATED 3         // Consecutive outliers before the tracker re-locks on the new range
+
+struct RangeFilter {
+  uint16_t window[TOF_MEDIAN_N]; // Last accepted raw samples (ring)
+  uint8_t head;
+  uint8_t count;
+  int32_t x;                     // Range estimate, mm in Q4
+  int32_t v;                     // Range rate, mm per sample in Q4
+  uint8_t misses;
+  uint8_t gated;
+  bool tracking;                 // Output is valid
+};
+
+void resetRangeFilter(RangeFilter* f);
+void updateRangeFilter(RangeFilter* f, uint16_t raw);   // New raw reading
+void missRangeFilter(RangeFilter* f);                   // No reading this frame
+uint16_t rangeFilterOutput(const RangeFilter* f);       // Filtered mm, TOF_NO_TARGET_MM if invalid
+
+//Closes one frame over filters[6]: expected channels that didn't report since
+//the last frame (not in freshMask) count as a miss. Fills distances[6] and
+//returns the mask of channels with a valid range.
+uint8_t closeRangeFrame(RangeFilter* filters, uint8_t freshMask, uint8_t expectedMask, uint32_t* distances);
+
 void initAllToFSensors();
 
 //FreeRTOS Task
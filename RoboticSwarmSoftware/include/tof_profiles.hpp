@@ -0,0 +1,50 @@
+#ifndef TOF_PROFILES_HPP
+#define TOF_PROFILES_HPP
+
+#include <Arduino.h>
+
+//VL53L0X ranging profiles, applied to all six sensors at once. A longer
+//timing budget and VCSEL periods, plus a lower signal rate limit, reach
+//further and range more accurately at the cost of sample rate (ST AN4846
+//and the Pololu library examples).
+//AUTO picks one from what the formation planner is doing: long range while
+//searching for distant neighbours, high speed while moving / holding among
+//close ones, default otherwise.
+
+enum TofProfile : uint8_t {
+  TOF_PROFILE_AUTO,
+  TOF_PROFILE_HIGH_SPEED,
+  TOF_PROFILE_DEFAULT,
+  TOF_PROFILE_LONG_RANGE,
+  TOF_PROFILE_COUNT
+};
+
+struct TofProfileSettings {
+  const char* name;            // As used in the "tof_profile" command field
+  uint32_t timingBudgetUs;     // Measurement timing budget
+  float    signalRateLimit;    // Minimum return signal rate, MCPS
+  uint8_t  preRangeVcsel;      // VCSEL pulse periods, PCLKs (pre range 12..18, final range 8..14, even)
+  uint8_t  finalRangeVcsel;
+  uint16_t periodMs;           // Continuous-mode inter-measurement period, 0 = back to back
+};
+
+static const TofProfileSettings TOF_PROFILES[TOF_PROFILE_COUNT] = {
+  {"auto",       0,     0.0f,  0,  0,  0},   // Resolved to one of the others, never applied
+  {"high_speed", 20000, 0.25f, 14, 10, 0},   // ~50 Hz, good to ~1.2 m
+  {"default",    33000, 0.25f, 14, 10, 0},   // Library defaults, ~30 Hz
+  {"long_range", 50000, 0.10f, 18, 14, 0},   // ~20 Hz, out to ~2 m
+};
+
+//Profile by name, false if there is none
+inline bool tofProfileFromName(const char* name, TofProfile* out) {
+  if (!name) return false;
+  for (uint8_t p = 0; p < TOF_PROFILE_COUNT; p++) {
+    if (strcmp(name, TOF_PROFILES[p].name) == 0) {
+      *out = (TofProfile)p;
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef TRAJECTORY_HPP
+#define TRAJECTORY_HPP
+
+#include <Arduino.h>
+
+//Coordinated three-wheel trajectory, run by the step engine at TRAJ_UPDATE_HZ.
+//A move is a straight line in wheel space. One jerk-limited (S-curve) speed
+//profile runs along the axis with the most steps to go, and every other
+//axis follows in proportion, so all wheels finish together. A new move
+//while one is running blends: the current wheel velocities are projected
+//onto the new direction and the profile continues from there instead of
+//restarting from rest. Wheel velocities are slew limited to the
+//acceleration limit, which rounds the corner between two segments.
+//Integer only (Q8 fixed point for speed, acceleration and jerk).
+
+#define TRAJ_AXES 3
+#define TRAJ_UPDATE_HZ 1000
+#define TRAJ_Q 8                // Fractional bits of speed / acceleration / jerk
+#define TRAJ_UNIT_Q 15          // Fractional bits of the per-axis direction
+#define TRAJ_CREEP_SPEED 40     // steps/s, floor while short of the target
+#define TRAJ_TRACK_GAIN 20      // 1/s, pulls an axis that lags back onto the line
+
+struct Trajectory {
+  // Limits, Q8
+  int32_t maxSpeed;       // steps/s
+  int32_t accel;          // steps/s^2
+  int32_t jerk;           // steps/s^3
+
+  // Current segment
+  bool active;
+  int32_t start[TRAJ_AXES];
+  int32_t target[TRAJ_AXES];
+  int32_t delta[TRAJ_AXES];
+  uint8_t dominant;       // Axis with the longest travel, the profile runs on it
+  int32_t length;         // |delta[dominant]|
+  int32_t unit[TRAJ_AXES];// delta / length, Q15, the dominant axis is +-1
+
+  // Profile along the dominant axis, Q8
+  int32_t speed;
+  int32_t accelNow;
+
+  // Output per axis, signed steps/s Q8
+  int32_t velocity[TRAJ_AXES];
+};
+
+void trajectoryInit(Trajectory* t, uint32_t maxSpeed, uint32_t accel, uint32_t jerk);
+
+//Moves every axis by relative[] from position[], blending with the motion
+//already in progress. An all-zero move holds position[].
+void trajectoryMove(Trajectory* t, const int32_t position[TRAJ_AXES], const int32_t relative[TRAJ_AXES]);
+
+//Returns to position[] and stays there; wheels still turning brake at the
+//acceleration limit and come back, like a retarget of the per-axis profiles
+void trajectoryHold(Trajectory* t, const int32_t position[TRAJ_AXES]);
+
+//Brakes along the current line as fast as the accel and jerk limits allow
+void trajectoryStop(Trajectory* t, const int32_t position[TRAJ_AXES]);
+
+//One TRAJ_UPDATE_HZ tick from the measured positions; refreshes velocity[].
+//False once every axis has reached its target.
+bool trajectoryUpdate(Trajectory* t, const int32_t position[TRAJ_AXES]);
+
+#endif
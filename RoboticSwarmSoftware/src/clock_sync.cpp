@@ -0,0 +1,98 @@
+#include "clock_sync.hpp"
+
+struct ClockSample {
+    int64_t offsetUs;
+    uint32_t roundTripUs;
+};
+
+static ClockSample samples[CLOCK_SYNC_WINDOW];
+static uint8_t sampleCount = 0;
+static uint8_t sampleNext = 0;
+static uint16_t pendingId = 0;
+static int64_t pendingT1 = -1;       // -1 = no request outstanding
+
+static int64_t offsetUs = 0;         // Best sample in the window
+static uint32_t accuracyUs = 0;
+static uint32_t lastRoundTripUs = 0;
+static int64_t lastAcceptedUs = 0;
+static uint32_t acceptedCount = 0;
+static uint32_t rejectedCount = 0;
+
+void clockSyncBuildRequest(ClockRequest* request, uint8_t robotId, int64_t localUs) {
+    pendingId++;
+    pendingT1 = localUs;
+
+    request->version = CLOCK_SYNC_VERSION;
+    request->robotId = robotId;
+    request->id = pendingId;
+    request->t1 = localUs;
+}
+
+// Minimum round trip in the window, the least queueing-distorted sample
+static void chooseEstimate() {
+    uint8_t best = 0;
+    for (uint8_t i = 1; i < sampleCount; i++) {
+        if (samples[i].roundTripUs < samples[best].roundTripUs) best = i;
+    }
+    offsetUs = samples[best].offsetUs;
+    accuracyUs = samples[best].roundTripUs / 2;
+}
+
+bool clockSyncOnResponse(const uint8_t* payload, size_t length, int64_t localUs) {
+    ClockResponse response;
+    if (length != sizeof(response)) {
+        rejectedCount++;
+        return false;
+    }
+    memcpy(&response, payload, sizeof(response));
+
+    // Only the outstanding request counts, late answers to older ones would skew the window
+    if (response.version != CLOCK_SYNC_VERSION || response.id != pendingId || response.t1 != pendingT1) {
+        rejectedCount++;
+        return false;
+    }
+    pendingT1 = -1;
+
+    int64_t roundTrip = (localUs - response.t1) - (response.t3 - response.t2);
+    if (roundTrip < 0 || roundTrip > UINT32_MAX) {
+        rejectedCount++;
+        return false;
+    }
+
+    ClockSample& s = samples[sampleNext];
+    s.offsetUs = ((response.t2 - response.t1) + (response.t3 - localUs)) / 2;
+    s.roundTripUs = (uint32_t)roundTrip;
+    sampleNext = (sampleNext + 1) % CLOCK_SYNC_WINDOW;
+    if (sampleCount < CLOCK_SYNC_WINDOW) sampleCount++;
+
+    chooseEstimate();
+    lastRoundTripUs = s.roundTripUs;
+    lastAcceptedUs = localUs;
+    acceptedCount++;
+    return true;
+}
+
+uint32_t clockSyncRequestPeriodMs() {
+    return (sampleCount < CLOCK_SYNC_WINDOW) ? CLOCK_SYNC_FAST_MS : CLOCK_SYNC_INTERVAL_MS;
+}
+
+bool clockSyncIsSynced(int64_t localUs) {
+    return acceptedCount > 0 && localUs - lastAcceptedUs < (int64_t)CLOCK_SYNC_MAX_AGE_MS * 1000;
+}
+
+int64_t clockSyncSwarmToLocal(int64_t swarmUs) {
+    return swarmUs - offsetUs;
+}
+
+int64_t clockSyncLocalToSwarm(int64_t localUs) {
+    return localUs + offsetUs;
+}
+
+void clockSyncGetStats(ClockSyncStats* stats, int64_t localUs) {
+    stats->synced = clockSyncIsSynced(localUs);
+    stats->offsetUs = offsetUs;
+    stats->accuracyUs = accuracyUs;
+    stats->lastRoundTripUs = lastRoundTripUs;
+    stats->samples = acceptedCount;
+    stats->rejected = rejectedCount;
+}
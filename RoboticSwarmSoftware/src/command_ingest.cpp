@@ -0,0 +1,248 @@
+#include "command_ingest.hpp"
+#include "tof_profiles.hpp"
+
+#define ARENA_ALIGN 8
+#define ARENA_HEADER ARENA_ALIGN // Block size stored in front of each block, keeps data aligned
+
+static const char BROADCAST_TOPIC[] = "command/broadcast";
+static const char INDIVIDUAL_PREFIX[] = "command/individual/";
+
+alignas(ARENA_ALIGN) static uint8_t arenaBuffer[COMMAND_ARENA_BYTES];
+static ArenaAllocator arena(arenaBuffer, sizeof(arenaBuffer));
+static JsonDocument commandDoc(&arena);
+
+// Filter keeping the shared fields and this robot's batch entries only
+alignas(ARENA_ALIGN) static uint8_t filterBuffer[COMMAND_FILTER_BYTES];
+static ArenaAllocator filterArena(filterBuffer, sizeof(filterBuffer));
+static JsonDocument commandFilter(&filterArena);
+static bool hasCommandFilter = false;
+static const char* batchHostname = nullptr;
+static char batchId[4] = "";
+
+// Every field a command (or a batch entry) may carry
+static const char* const COMMAND_FIELDS[] = {
+    "mode", "neighbor_maxDist", "idle_thresh", "line_nodeDist", "line_alignTol",
+    "polygon_sides", "polygon_radius", "polygon_alignTol", "telemetry_hz", "peer_hz",
+    "tof_profile", "recorder", "l", "r", "b", "execute_at", "sid", "seq"
+};
+
+//-------------------------
+// Arena allocator
+//-------------------------
+static size_t alignUp(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+ArenaAllocator::ArenaAllocator(uint8_t* buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity), top(0), last(0), peak(0), failed(0) {}
+
+void* ArenaAllocator::allocate(size_t size) {
+    size_t need = ARENA_HEADER + alignUp(size);
+    if (top + need > capacity) {
+        failed++;
+        return nullptr; // ArduinoJson reports NoMemory
+    }
+    uint8_t* block = buffer + top;
+    *(size_t*)block = size;
+    last = top;
+    top += need;
+    if (top > peak) peak = top;
+    return block + ARENA_HEADER;
+}
+
+void ArenaAllocator::deallocate(void* ptr) {
+    (void)ptr; // Released in bulk by reset()
+}
+
+void* ArenaAllocator::reallocate(void* ptr, size_t newSize) {
+    if (!ptr) return allocate(newSize);
+
+    uint8_t* block = (uint8_t*)ptr - ARENA_HEADER;
+    size_t oldSize = *(size_t*)block;
+
+    // Shrinking, or growing the newest block while there is room: stay in place
+    if (newSize <= oldSize) {
+        *(size_t*)block = newSize;
+        if ((size_t)(block - buffer) == last) top = last + ARENA_HEADER + alignUp(newSize);
+        return ptr;
+    }
+    if ((size_t)(block - buffer) == last && last + ARENA_HEADER + alignUp(newSize) <= capacity) {
+        *(size_t*)block = newSize;
+        top = last + ARENA_HEADER + alignUp(newSize);
+        if (top > peak) peak = top;
+        return ptr;
+    }
+
+    void* moved = allocate(newSize);
+    if (moved) memcpy(moved, ptr, oldSize);
+    return moved;
+}
+
+void ArenaAllocator::reset() {
+    top = 0;
+    last = 0;
+}
+
+const ArenaAllocator& commandArena() {
+    return arena;
+}
+
+//-------------------------
+// Topic matching
+//-------------------------
+CommandTopic matchCommandTopic(const char* topic, const char* hostname) {
+    if (strcmp(topic, BROADCAST_TOPIC) == 0) return TOPIC_BROADCAST;
+
+    const size_t prefixLen = sizeof(INDIVIDUAL_PREFIX) - 1;
+    if (strncmp(topic, INDIVIDUAL_PREFIX, prefixLen) == 0 && strcmp(topic + prefixLen, hostname) == 0) {
+        return TOPIC_INDIVIDUAL;
+    }
+    return TOPIC_OTHER;
+}
+
+//-------------------------
+// Parsing
+//-------------------------
+static bool parseMode(const char* mode, Config::Mode* out) {
+    if (!mode) return false;
+    if (strcmp(mode, "OFF") == 0) *out = Config::OFF;
+    else if (strcmp(mode, "IDLE") == 0) *out = Config::IDLE;
+    else if (strcmp(mode, "LINE") == 0) *out = Config::LINE;
+    else if (strcmp(mode, "POLYGON") == 0) *out = Config::POLYGON;
+    else if (strcmp(mode, "MANUAL") == 0) *out = Config::MANUAL;
+    else return false;
+    return true;
+}
+
+template <typename T>
+static bool readField(JsonVariantConst value, T* out) {
+    if (value.isNull()) return false;
+    *out = value.as<T>();
+    return true;
+}
+
+static void readMoveSteps(JsonVariantConst value, int32_t* out) {
+    int64_t steps;
+    if (readField(value, &steps)) *out = (int32_t)constrain(steps, -COMMAND_MAX_MOVE_STEPS, COMMAND_MAX_MOVE_STEPS);
+}
+
+// Reads the fields present in src, leaving everything else in out as it was,
+// so a batch entry can override the shared fields
+static void readCommandFields(JsonVariantConst src, ParsedCommand* out) {
+    if (parseMode(src["mode"].as<const char*>(), &out->mode)) out->hasMode = true;
+    if (readField(src["neighbor_maxDist"], &out->neighborMaxDist)) out->hasNeighborMaxDist = true;
+    if (readField(src["idle_thresh"], &out->idleThresh)) out->hasIdleThresh = true;
+    if (readField(src["line_nodeDist"], &out->lineNodeDist)) out->hasLineNodeDist = true;
+    if (readField(src["line_alignTol"], &out->lineAlignTol)) out->hasLineAlignTol = true;
+    if (readField(src["polygon_sides"], &out->polygonSides)) out->hasPolygonSides = true;
+    if (readField(src["polygon_radius"], &out->polygonRadius)) out->hasPolygonRadius = true;
+    if (readField(src["polygon_alignTol"], &out->polygonAlignTol)) out->hasPolygonAlignTol = true;
+
+    int telemetryHz;
+    if (readField(src["telemetry_hz"], &telemetryHz)) {
+        out->hasTelemetryHz = true;
+        out->telemetryHz = constrain(telemetryHz, 0, 255);
+    }
+
+    int peerHz;
+    if (readField(src["peer_hz"], &peerHz)) {
+        out->hasPeerHz = true;
+        out->peerHz = constrain(peerHz, 0, 255);
+    }
+
+    TofProfile tofProfile;
+    if (tofProfileFromName(src["tof_profile"].as<const char*>(), &tofProfile)) {
+        out->hasTofProfile = true;
+        out->tofProfile = tofProfile;
+    }
+
+    const char* recorder = src["recorder"] | "";
+    if (strcmp(recorder, "trigger") == 0) out->recorder = RECORDER_TRIGGER;
+    else if (strcmp(recorder, "dump") == 0) out->recorder = RECORDER_DUMP;
+    else if (strcmp(recorder, "arm") == 0) out->recorder = RECORDER_ARM;
+
+    // Manual move commands, bounded so the step engine's int32 positions and
+    // targets never wrap
+    readMoveSteps(src["l"], &out->l);
+    readMoveSteps(src["r"], &out->r);
+    readMoveSteps(src["b"], &out->b);
+
+    if (readField(src["execute_at"], &out->executeAtMs)) out->hasExecuteAt = true;
+}
+
+bool setCommandAddress(const char* hostname, uint8_t robotId) {
+    batchHostname = hostname;
+    snprintf(batchId, sizeof(batchId), "%u", (unsigned)robotId);
+
+    commandFilter.clear();
+    filterArena.reset();
+    for (size_t i = 0; i < sizeof(COMMAND_FIELDS) / sizeof(COMMAND_FIELDS[0]); i++) {
+        commandFilter[COMMAND_FIELDS[i]] = true;
+    }
+    commandFilter["robots"][batchHostname] = true;
+    commandFilter["robots"][(const char*)batchId] = true;
+    hasCommandFilter = !commandFilter.overflowed();
+    return hasCommandFilter;
+}
+
+DeserializationError parseCommand(const uint8_t* payload, size_t length, ParsedCommand* out) {
+    // Drop the previous document before recycling its memory
+    commandDoc.clear();
+    arena.reset();
+
+    memset(out, 0, sizeof(*out));
+
+    // With the filter, other robots' batch entries are scanned past without being stored
+    DeserializationError error = hasCommandFilter
+        ? deserializeJson(commandDoc, (const char*)payload, length, DeserializationOption::Filter(commandFilter))
+        : deserializeJson(commandDoc, (const char*)payload, length);
+    if (error) return error;
+
+    JsonVariantConst doc = commandDoc.as<JsonVariantConst>();
+    readCommandFields(doc, out);
+
+    // This robot's batch entry, by hostname first, then by ID
+    if (hasCommandFilter) {
+        JsonVariantConst entry = doc["robots"][batchHostname];
+        if (!entry.is<JsonObjectConst>()) entry = doc["robots"][(const char*)batchId];
+        if (entry.is<JsonObjectConst>()) {
+            readCommandFields(entry, out);
+            out->hasBatchEntry = true;
+        }
+    }
+
+    out->hasManualMove = (out->l != 0 || out->r != 0 || out->b != 0);
+
+    // Sequence numbering is optional, unnumbered commands are never deduplicated.
+    // Always top-level: the whole batch is one numbered command.
+    out->hasSeq = readField(doc["seq"], &out->seq);
+    if (out->hasSeq) out->session = doc["sid"] | 0u;
+
+    return error;
+}
+
+//-------------------------
+// Replay window
+//-------------------------
+bool replayWindowAccept(ReplayWindow* window, uint32_t session, uint32_t seq) {
+    if (!window->primed || session != window->session) {
+        window->primed = true;
+        window->session = session;
+        window->highest = seq;
+        window->seen = 1;
+        return true;
+    }
+
+    if (seq > window->highest) {
+        uint32_t shift = seq - window->highest;
+        window->seen = (shift >= REPLAY_WINDOW_BITS) ? 1 : ((window->seen << shift) | 1);
+        window->highest = seq;
+        return true;
+    }
+
+    uint32_t age = window->highest - seq;
+    if (age >= REPLAY_WINDOW_BITS) return false;          // Too old to tell, treat as replay
+    if (window->seen & (1UL << age)) return false;         // Already applied
+    window->seen |= (1UL << age);                          // Late but new (reordered)
+    return true;
+}
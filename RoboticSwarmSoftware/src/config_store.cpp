@@ -0,0 +1,74 @@
+#include <Preferences.h>
+
+#include "config_store.hpp"
+
+#define STORE_NAMESPACE "swarm"
+
+static Preferences prefs;
+
+// Last Config written (or read), so unchanged saves skip the flash
+static Config storedConfig;
+static bool storedConfigValid = false;
+
+//-----------------------------------------------
+// Formation config
+bool configStoreLoad(Config* out) {
+  if (!prefs.begin(STORE_NAMESPACE, true)) return false;
+
+  Config cfg = Config();
+  bool ok = prefs.getUInt("cfg_ver", 0) == CONFIG_STORE_VERSION &&
+            prefs.getBytesLength("cfg") == sizeof(Config) &&
+            prefs.getBytes("cfg", &cfg, sizeof(Config)) == sizeof(Config);
+  prefs.end();
+
+  // Don't trust a blob that decodes to an impossible mode
+  if (!ok || cfg.mode > Config::MANUAL) return false;
+
+  *out = cfg;
+  storedConfig = cfg;
+  storedConfigValid = true;
+  return true;
+}
+
+void configStoreSave(const Config& cfg) {
+  if (storedConfigValid && memcmp(&storedConfig, &cfg, sizeof(Config)) == 0) return;
+  if (!prefs.begin(STORE_NAMESPACE, false)) return;
+
+  bool ok = prefs.putBytes("cfg", &cfg, sizeof(Config)) == sizeof(Config);
+  if (ok) ok = prefs.putUInt("cfg_ver", CONFIG_STORE_VERSION) > 0;
+  prefs.end();
+
+  if (ok) {
+    storedConfig = cfg;
+    storedConfigValid = true;
+  }
+}
+
+//-----------------------------------------------
+// WiFi association cache
+bool wifiCacheLoad(WifiCache* out) {
+  if (!prefs.begin(STORE_NAMESPACE, true)) return false;
+
+  WifiCache cache;
+  bool ok = prefs.getBytesLength("wifi") == sizeof(WifiCache) &&
+            prefs.getBytes("wifi", &cache, sizeof(WifiCache)) == sizeof(WifiCache);
+  prefs.end();
+
+  if (!ok || cache.channel < 1 || cache.channel > 14) return false;
+  *out = cache;
+  return true;
+}
+
+void wifiCacheSave(const WifiCache& cache) {
+  WifiCache stored;
+  if (wifiCacheLoad(&stored) && memcmp(&stored, &cache, sizeof(WifiCache)) == 0) return;
+  if (!prefs.begin(STORE_NAMESPACE, false)) return;
+  prefs.putBytes("wifi", &cache, sizeof(WifiCache));
+  prefs.end();
+}
+
+void wifiCacheClear() {
+  if (!prefs.begin(STORE_NAMESPACE, false)) return;
+  prefs.remove("wifi");
+  prefs.end();
+}
@@ -0,0 +1,120 @@
+#include <atomic>
+#include "flight_recorder.hpp"
+
+static FlightRecord records[RECORDER_RECORDS];
+static std::atomic<uint32_t> nextRecord(0);       // Total records claimed since arming
+static std::atomic<uint32_t> stopAt(UINT32_MAX);  // Claims at or past this are dropped
+static uint32_t dumpStart = 0;                    // First record in the dump, oldest kept
+static uint32_t dumpCount = 0;
+static uint32_t dumpId = 0;
+
+//-------------------------
+// Recording
+//-------------------------
+// Claims the next slot, nullptr once frozen. Lock-free, any task.
+static FlightRecord* claim(RecordType type) {
+    uint32_t n = nextRecord.fetch_add(1, std::memory_order_relaxed);
+    if (n >= stopAt.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    FlightRecord* rec = &records[n % RECORDER_RECORDS];
+    rec->timeUs = micros();
+    rec->type = type;
+    return rec;
+}
+
+static int16_t clamp16(int32_t value) {
+    return (int16_t)constrain(value, -32768, 32767);
+}
+
+void recordTofFrame(const uint32_t* distances, uint8_t validMask, uint32_t frameSeq) {
+    FlightRecord* rec = claim(REC_TOF_FRAME);
+    if (!rec) return;
+    rec->arg = validMask;
+    for (int i = 0; i < 6; i++) rec->data[i] = clamp16(min<uint32_t>(distances[i], 32767));
+    rec->data[6] = (int16_t)(frameSeq & 0xFFFF);
+}
+
+void recordDecision(uint8_t mode, int result, bool isBearing) {
+    FlightRecord* rec = claim(isBearing ? REC_DECISION_BEARING : REC_DECISION_SENSOR);
+    if (!rec) return;
+    rec->arg = mode;
+    rec->data[0] = clamp16(result);
+}
+
+void recordMotorTarget(int left, int right, int back) {
+    FlightRecord* rec = claim(REC_MOTOR_TARGET);
+    if (!rec) return;
+    rec->arg = 0;
+    rec->data[0] = clamp16(left);
+    rec->data[1] = clamp16(right);
+    rec->data[2] = clamp16(back);
+}
+
+//-------------------------
+// Trigger / arm
+//-------------------------
+void recorderTrigger(uint8_t source) {
+    if (recorderFrozen()) return;
+
+    FlightRecord* rec = claim(REC_TRIGGER);
+    if (rec) rec->arg = source;
+
+    uint32_t stop = nextRecord.load(std::memory_order_relaxed) + RECORDER_POST_TRIGGER;
+    uint32_t expected = UINT32_MAX;
+    stopAt.compare_exchange_strong(expected, stop); // First trigger wins
+}
+
+void recorderArm() {
+    stopAt.store(0); // Park writers while clearing
+    memset(records, 0, sizeof(records));
+    nextRecord.store(0);
+    stopAt.store(UINT32_MAX);
+}
+
+bool recorderFrozen() {
+    return stopAt.load(std::memory_order_relaxed) != UINT32_MAX &&
+           nextRecord.load(std::memory_order_relaxed) >= stopAt.load(std::memory_order_relaxed);
+}
+
+//-------------------------
+// Dump
+//-------------------------
+uint16_t recorderStartDump() {
+    // Freeze right here, cutting short any post-trigger capture still running
+    uint32_t now = nextRecord.load();
+    if (now < stopAt.load()) stopAt.store(now);
+
+    // Writers that claimed a slot just before the freeze finish within a few
+    // microseconds; the network task reads chunks much later than that
+    uint32_t end = min(nextRecord.load(), stopAt.load());
+    dumpCount = min<uint32_t>(end, RECORDER_RECORDS);
+    dumpStart = end - dumpCount;
+    dumpId++;
+
+    return (dumpCount + RECORDER_CHUNK_RECORDS - 1) / RECORDER_CHUNK_RECORDS;
+}
+
+size_t recorderReadChunk(uint16_t chunkIndex, uint8_t* buffer, size_t bufferSize) {
+    uint16_t chunkCount = (dumpCount + RECORDER_CHUNK_RECORDS - 1) / RECORDER_CHUNK_RECORDS;
+    if (chunkIndex >= chunkCount || bufferSize < RECORDER_CHUNK_BYTES) return 0;
+
+    uint32_t first = chunkIndex * RECORDER_CHUNK_RECORDS;
+    uint16_t count = min<uint32_t>(RECORDER_CHUNK_RECORDS, dumpCount - first);
+
+    RecorderChunkHeader header;
+    header.version = RECORDER_VERSION;
+    header.recordSize = sizeof(FlightRecord);
+    header.chunkIndex = chunkIndex;
+    header.chunkCount = chunkCount;
+    header.recordCount = count;
+    header.dumpId = dumpId;
+    memcpy(buffer, &header, sizeof(header));
+
+    uint8_t* out = buffer + sizeof(header);
+    for (uint16_t i = 0; i < count; i++) {
+        memcpy(out, &records[(dumpStart + first + i) % RECORDER_RECORDS], sizeof(FlightRecord));
+        out += sizeof(FlightRecord);
+    }
+    return out - buffer;
+}
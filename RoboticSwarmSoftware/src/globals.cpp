@@ -1,7 +1,17 @@
 #include "globals.hpp"
 
-State state = { State::OFF, 0, 0, 0, 0, 0, 0, 0, {0}};
+SeqLock<Config> configLock;
+SeqLock<SensorFrame> sensorLock;
+SeqLock<NeighborFrame> neighborLock;
+SeqLock<PeerFrame> peerLock;
+SeqLock<PoseFrame> poseLock;
+SeqLock<ClockFrame> clockLock;
 int tof_ch_order[6] = {2, 1, 0, 5, 4, 3}; 
 int ir_ch_order[6] = {0, 1, 2, 3, 4, 5};
 
-SemaphoreHandle_t stateMutex;
\ No newline at end of file
+void snapshotState(State& out) {
+  configLock.read(static_cast<Config&>(out));
+  sensorLock.read(static_cast<SensorFrame&>(out));
+  neighborLock.read(static_cast<NeighborFrame&>(out));
+  poseLock.read(static_cast<PoseFrame&>(out));
+}
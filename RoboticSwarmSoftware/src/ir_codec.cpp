@@ -0,0 +1,151 @@
+#include "ir_codec.hpp"
+
+//-------------------------
+// Timing
+//-------------------------
+constexpr uint16_t START_MARK_US = 2000;
+constexpr uint16_t START_SPACE_US = 1000;
+constexpr uint16_t BIT_HALF_US = 560;
+
+static inline bool inRange(uint32_t v, uint32_t lo, uint32_t hi) {
+    return v > lo && v < hi;
+}
+
+static bool isStart(const rmt_item32_t& item) {
+    return item.level0 == 0 && item.level1 == 1 &&
+           inRange(item.duration0, 1900, 2100) &&
+           inRange(item.duration1, 900, 1100);
+}
+
+// Returns 0 / 1 for a valid bit cell, -1 otherwise
+static int bitValue(const rmt_item32_t& item) {
+    if (item.duration0 < 500 || item.duration0 > 620 ||
+        item.duration1 < 500 || item.duration1 > 620) return -1;
+    if (item.level0 == 1 && item.level1 == 0) return 1;
+    if (item.level0 == 0 && item.level1 == 1) return 0;
+    return -1;
+}
+
+//-------------------------
+// CRC
+//-------------------------
+uint8_t irCrc8(uint8_t crc, uint8_t data) {
+    crc ^= data;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+//-------------------------
+// Decoder
+//-------------------------
+void irDecoderReset(IRDecoder* dec) {
+    dec->phase = IRDecoder::HUNT;
+    dec->bitCount = 0;
+    dec->current = 0;
+    dec->length = 0;
+    dec->index = 0;
+    dec->crc = 0;
+}
+
+// Starts a new frame if item is a start pulse
+static void hunt(IRDecoder* dec, const rmt_item32_t& item) {
+    if (!isStart(item)) return;
+    dec->phase = IRDecoder::LENGTH;
+    dec->bitCount = 0;
+    dec->current = 0;
+    dec->index = 0;
+    dec->crc = 0;
+}
+
+uint8_t irDecoderFeed(IRDecoder* dec, const rmt_item32_t& item) {
+    int bit = bitValue(item);
+    if (bit >= 0 || isStart(item)) dec->itemsIntact++;
+
+    if (dec->phase == IRDecoder::HUNT) {
+        hunt(dec, item);
+        return 0;
+    }
+
+    if (bit < 0) {
+        // Broken frame: resynchronise, this item may itself be a new start
+        dec->framesBad++;
+        dec->phase = IRDecoder::HUNT;
+        hunt(dec, item);
+        return 0;
+    }
+
+    if (bit) dec->current |= (1 << dec->bitCount); // LSB first
+    if (++dec->bitCount < 8) return 0;
+
+    uint8_t byte = dec->current;
+    dec->bitCount = 0;
+    dec->current = 0;
+
+    switch (dec->phase) {
+        case IRDecoder::LENGTH:
+            if (byte == 0 || byte > IR_MAX_PAYLOAD) {
+                dec->framesBad++;
+                dec->phase = IRDecoder::HUNT;
+                return 0;
+            }
+            dec->length = byte;
+            dec->crc = irCrc8(0, byte);
+            dec->phase = IRDecoder::PAYLOAD;
+            return 0;
+
+        case IRDecoder::PAYLOAD:
+            dec->payload[dec->index++] = byte;
+            dec->crc = irCrc8(dec->crc, byte);
+            if (dec->index == dec->length) dec->phase = IRDecoder::CHECKSUM;
+            return 0;
+
+        case IRDecoder::CHECKSUM:
+            dec->phase = IRDecoder::HUNT;
+            if (byte != dec->crc) {
+                dec->framesBad++;
+                return 0;
+            }
+            dec->framesOk++;
+            return dec->length;
+
+        default:
+            dec->phase = IRDecoder::HUNT;
+            return 0;
+    }
+}
+
+//-------------------------
+// Encoder
+//-------------------------
+static void encodeByte(uint8_t value, rmt_item32_t* items) {
+    for (int i = 0; i < 8; i++) {
+        bool bit = (value >> i) & 0x01;
+        items[i].level0 = bit ? 0 : 1;
+        items[i].level1 = bit ? 1 : 0;
+        items[i].duration0 = BIT_HALF_US;
+        items[i].duration1 = BIT_HALF_US;
+    }
+}
+
+size_t irEncodeFrame(const uint8_t* payload, uint8_t len, rmt_item32_t* items, size_t maxItems) {
+    size_t count = 1 + ((size_t)len + 2) * 8;
+    if (len == 0 || len > IR_MAX_PAYLOAD || count > maxItems) return 0;
+
+    // Start pulse
+    items[0].level0 = 1;
+    items[0].level1 = 0;
+    items[0].duration0 = START_MARK_US;
+    items[0].duration1 = START_SPACE_US;
+
+    uint8_t crc = irCrc8(0, len);
+    encodeByte(len, &items[1]);
+    for (uint8_t i = 0; i < len; i++) {
+        encodeByte(payload[i], &items[1 + (i + 1) * 8]);
+        crc = irCrc8(crc, payload[i]);
+    }
+    encodeByte(crc, &items[1 + (len + 1) * 8]);
+
+    return count;
+}
@@ -1,6 +1,12 @@
+#include <esp_timer.h>
+
 #include "ir_module.hpp"
+#include "ir_codec.hpp"
 #include "driver/rmt.h"
 #include "globals.hpp"
+#include "network_module.hpp"
+#include "motor_module.hpp"
+#include "task_stats.hpp"
 
 //-------------------------
 // Config / Pins
@@ -10,12 +16,76 @@ static uint8_t s0_pin, s1_pin, s2_pin; // SN74CB3Q3251 addressing pins
 // Helper function prototypes (private)
 static void setChannel(uint8_t channel);
 static void setupRMT(uint8_t tx_pin, uint8_t rx_pin);
-static int decodeIRItems(rmt_item32_t* items, size_t num_items);
-static int transmitID(uint8_t channel, uint8_t ID);
-static int receiveID(uint8_t channel);
+struct IRBeacon;
+static bool transmitBeacon(uint8_t channel, const IRBeacon& beacon);
+static bool transmitDone();
+static void startReceive(uint8_t channel);
+static bool pollReceive(IRBeacon* beacon);
+static void stopReceive();
+static int8_t irChannelToDirection(uint8_t channel);
+
+// ESP32-S3 RMT: channels 0-3 transmit only, 4-7 receive only
+constexpr rmt_channel_t IR_TX_CHANNEL = RMT_CHANNEL_0;
+constexpr rmt_channel_t IR_RX_CHANNEL = RMT_CHANNEL_4;
+
+//-------------------------
+// Beacon Payload
+//-------------------------
+// Sent in every frame: who we are and our formation role (FormationRole).
+// No heading: odometry is in each robot's own power-on frame, meaningless to
+// a neighbour, and every byte adds 9 ms to each of the 42 sub-slots of a cycle.
+// No slot number either, occupancy is taken from when a beacon arrives.
+struct IRBeacon {
+    uint8_t id;
+    uint8_t role;
+};
+
+constexpr uint8_t IR_BEACON_LEN = 2; // id, role
+
+static IRDecoder decoder;
 
-// Timing constants
-constexpr uint32_t RX_TIMEOUT_MS = 30;
+//-------------------------
+// TDMA Schedule
+//-------------------------
+// Every robot owns one slot per cycle. In its own slot it sends its ID once
+// on each of the six IR directions (one sub-slot each); in every other slot
+// it listens on a single direction, rotating the direction each slot.
+// Every few cycles a robot keeps quiet in its own slot and listens instead,
+// which is how two robots that picked the same slot find out.
+// IR_SLOT_COUNT is coprime with 6 so a listener visits every direction
+// within 6 cycles of any neighbour's slot, which bounds discovery latency to
+// 6 * IR_SLOT_COUNT * IR_SLOT_MS. A slot counts as taken when a beacon
+// decodes in it here: that is the sender's slot once clocks are aligned, and
+// where its frames actually land on this robot while they are not.
+// Slots are cut from the swarm clock (clock_sync.hpp), so slot k is the same
+// window on every robot. Each robot's estimate is off by up to its accuracy,
+// two robots by twice that, so it is only trusted within half the guard left
+// at the end of each slot. Until then, or once it goes stale, the local clock
+// is used and slots line up only by chance.
+// Budget: a 2-byte beacon frame is 38.8 ms on air (length and CRC bytes
+// included), so a sub-slot is 40 ms, a slot 260 ms with its guard, a cycle
+// 1.82 s and discovery takes at most ~11 s, 5.5 s on average. The bare 8-bit
+// ID frames this replaced managed 3.5 s, but a corrupted one read as some
+// other robot's ID; a wrong ID makes the planner steer on the wrong
+// neighbour, a late one only keeps a contact classed as unknown a little
+// longer. The bit timing stays at the NEC-style 560 us the receivers were
+// chosen for.
+constexpr uint8_t  IR_DIRECTIONS = 6;
+constexpr uint8_t  IR_SLOT_COUNT = 7;
+constexpr uint32_t IR_SUBSLOT_MS = IR_FRAME_US(IR_BEACON_LEN) / 1000 + 2; // One beacon frame plus guard
+constexpr uint32_t IR_SLOT_GUARD_MS = 20;                                  // Quiet tail of a slot, absorbs clock sync error
+constexpr uint32_t IR_SLOT_MS = IR_SUBSLOT_MS * IR_DIRECTIONS + IR_SLOT_GUARD_MS;
+constexpr uint32_t IR_SYNC_ACCURACY_US = IR_SLOT_GUARD_MS * 1000 / 2;      // Coarser swarm clock estimates aren't used
+constexpr uint32_t IR_CYCLE_MS = IR_SLOT_MS * IR_SLOT_COUNT;
+constexpr uint32_t IR_NEIGHBOR_TIMEOUT_MS = 8 * IR_CYCLE_MS;   // Forget a direction after this long
+constexpr uint32_t IR_SLOT_TIMEOUT_MS = 8 * IR_CYCLE_MS;       // Forget slot occupancy after this long
+constexpr uint8_t  IR_NO_ID = 0xFF;
+constexpr uint8_t  IR_QUALITY_DECAY = 255 / 8;                 // Per cycle, a silent direction fades out in 8 cycles
+constexpr uint32_t IR_LISTEN_OWN_EVERY = 4;                   // Stay silent in our slot every Nth cycle to detect collisions
+
+static uint8_t mySlot = 0;
+static uint32_t slotHeardMs[IR_SLOT_COUNT] = {0};   // Last time a neighbour was heard in each of our slots
+static uint8_t slotHeardId[IR_SLOT_COUNT] = {0};    // ...and which neighbour
 
 //-------------------------
 // Public Setup
@@ -35,10 +105,146 @@ void setupIR(uint8_t s0, uint8_t s1, uint8_t s2, uint8_t tx_pin, uint8_t rx_pin)
 //-------------------------
 // FreeRTOS Task
 //-------------------------
+// Picks a slot nobody nearby is using. Default is ID % IR_SLOT_COUNT; if a
+// lower-ID neighbour is heard in our slot we move to the lowest free one.
+static uint8_t chooseSlot(uint8_t myId, uint32_t now) {
+    uint8_t preferred = myId % IR_SLOT_COUNT;
+    uint8_t current = mySlot;
+
+    bool currentTaken = (now - slotHeardMs[current] < IR_SLOT_TIMEOUT_MS) && slotHeardMs[current] != 0 &&
+                        slotHeardId[current] < myId;
+    if (!currentTaken) {
+        // Drift back to the preferred slot once it is free again
+        bool preferredFree = slotHeardMs[preferred] == 0 || now - slotHeardMs[preferred] >= IR_SLOT_TIMEOUT_MS;
+        return preferredFree ? preferred : current;
+    }
+
+    for (uint8_t s = 0; s < IR_SLOT_COUNT; s++) {
+        if (slotHeardMs[s] == 0 || now - slotHeardMs[s] >= IR_SLOT_TIMEOUT_MS) return s;
+    }
+    return current; // Every slot busy, keep ours and rely on decode errors being rejected
+}
+
+// TDMA time base in ms: the swarm clock while the estimate is fresh and
+// accurate enough, the local clock otherwise
+static uint64_t tdmaClockMs() {
+    static ClockFrame clock = {}; // Keeps the last good read if the writer is mid-update
+    clockLock.read(clock);
+
+    int64_t us = esp_timer_get_time();
+    if (clock.clock_synced && clock.clock_accuracyUs <= IR_SYNC_ACCURACY_US) us += clock.clock_offsetUs;
+    return (uint64_t)us / 1000;
+}
+
 void IRsensorTask(void* parameter) {
+    const uint8_t myId = getRobotId();
+    NeighborFrame published = {};
+    uint32_t heardMs[IR_DIRECTIONS] = {0};
+
+    for (uint8_t d = 0; d < IR_DIRECTIONS; d++) published.neighbor_ids[d] = -1;
+    neighborLock.write(published);
+
+    mySlot = myId % IR_SLOT_COUNT;
+    irDecoderReset(&decoder);
+
+    uint64_t lastSlotNumber = UINT64_MAX;
+    int8_t lastSubslot = -1;
+    bool transmitting = false;
+    bool listening = false;
+    int8_t listenDirection = -1;
+    uint32_t intactAtStart = 0;       // decoder.itemsIntact when the listen slot opened
+    bool beaconThisSlot = false;
+
     while (true) {
-        // Placeholder for future periodic IR operations
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        uint32_t loopStart = cycleCount();
+        uint32_t now = millis();                         // Timeouts, always local
+        uint64_t clockMs = tdmaClockMs();
+        uint64_t slotNumber = clockMs / IR_SLOT_MS;      // Slot counter, jumps once when the swarm clock takes over
+        uint8_t slot = slotNumber % IR_SLOT_COUNT;
+        int8_t subslot = (clockMs % IR_SLOT_MS) / IR_SUBSLOT_MS; // IR_DIRECTIONS = guard
+        bool changed = false;
+
+        // --- Slot boundary: close the previous slot, open the next ---
+        if (slotNumber != lastSlotNumber) {
+            if (listening) {
+                stopReceive();
+                listening = false;
+
+                // Detection quality: a decoded beacon is a perfect score,
+                // otherwise the share of one frame's pulses that arrived intact
+                int8_t dir = irChannelToDirection(listenDirection);
+                if (dir >= 0) {
+                    uint32_t intact = decoder.itemsIntact - intactAtStart;
+                    uint32_t sample = beaconThisSlot ? 255 : min<uint32_t>(255, intact * 255 / IR_FRAME_ITEMS(IR_BEACON_LEN));
+                    if (sample > published.ir_quality[dir]) {
+                        published.ir_quality[dir] = sample; // Peak hold, decays per cycle
+                        changed = true;
+                    }
+                }
+            }
+            transmitting = false;
+            lastSubslot = -1;
+
+            if (slot == 0) {
+                // New cycle: age out directions and re-evaluate our slot
+                for (uint8_t d = 0; d < IR_DIRECTIONS; d++) {
+                    if (published.neighbor_ids[d] >= 0 && now - heardMs[d] >= IR_NEIGHBOR_TIMEOUT_MS) {
+                        published.neighbor_ids[d] = -1;
+                        published.neighbor_roles[d] = ROLE_NONE;
+                    }
+                }
+                for (uint8_t d = 0; d < IR_DIRECTIONS; d++) {
+                    uint8_t q = published.ir_quality[d];
+                    published.ir_quality[d] = (q > IR_QUALITY_DECAY) ? q - IR_QUALITY_DECAY : 0;
+                }
+                mySlot = chooseSlot(myId, now);
+                published.ir_cycleSeq++;
+                changed = true;
+            }
+
+            bool listenOwnSlot = ((published.ir_cycleSeq + myId) % IR_LISTEN_OWN_EVERY) == 0;
+            if (slot == mySlot && !listenOwnSlot) {
+                transmitting = true;
+            } else {
+                // Rotate the listening direction every slot
+                listenDirection = slotNumber % IR_DIRECTIONS;
+                startReceive(listenDirection);
+                listening = true;
+                intactAtStart = decoder.itemsIntact;
+                beaconThisSlot = false;
+            }
+            lastSlotNumber = slotNumber;
+        }
+
+        // --- Own slot: one frame per direction, never waiting on the RMT ---
+        if (transmitting && subslot < IR_DIRECTIONS && subslot != lastSubslot && transmitDone()) {
+            IRBeacon beacon = { myId, (uint8_t)getFormationRole() };
+            transmitBeacon(subslot, beacon);
+            lastSubslot = subslot;
+        }
+
+        // --- Other slots: drain whatever the receiver captured ---
+        if (listening) {
+            IRBeacon beacon;
+            if (pollReceive(&beacon) && beacon.id != myId && beacon.id != IR_NO_ID) {
+                beaconThisSlot = true;
+                int8_t dir = irChannelToDirection(listenDirection);
+                if (dir >= 0) {
+                    if (published.neighbor_ids[dir] != beacon.id || published.neighbor_roles[dir] != beacon.role) changed = true;
+                    published.neighbor_ids[dir] = beacon.id;
+                    published.neighbor_roles[dir] = beacon.role;
+                    heardMs[dir] = now;
+                }
+                // Against the slot it arrived in, whatever the sender's own clock says
+                slotHeardMs[slot] = now ? now : 1;
+                slotHeardId[slot] = beacon.id;
+            }
+        }
+
+        if (changed) neighborLock.write(published);
+        latencyRecord(PROBE_IR_LOOP, cycleCount() - loopStart);
+
+        vTaskDelay(pdMS_TO_TICKS(1));
     }
 }
 
@@ -55,7 +261,7 @@ static void setupRMT(uint8_t tx_pin, uint8_t rx_pin) {
     // TX config
     rmt_config_t txConfig = {};
     txConfig.rmt_mode = RMT_MODE_TX;
-    txConfig.channel = RMT_CHANNEL_0;
+    txConfig.channel = IR_TX_CHANNEL;
     txConfig.gpio_num = (gpio_num_t)tx_pin;
     txConfig.clk_div = 80;  // 1us tick
     txConfig.mem_block_num = 1;
@@ -68,102 +274,84 @@ static void setupRMT(uint8_t tx_pin, uint8_t rx_pin) {
     txConfig.tx_config.idle_output_en = true;
 
     rmt_config(&txConfig);
-    rmt_driver_install(RMT_CHANNEL_0, 0, 0);
+    rmt_driver_install(IR_TX_CHANNEL, 0, 0);
 
     // RX config
     rmt_config_t rxConfig = {};
     rxConfig.rmt_mode = RMT_MODE_RX;
-    rxConfig.channel = RMT_CHANNEL_1;
+    rxConfig.channel = IR_RX_CHANNEL;
     rxConfig.gpio_num = (gpio_num_t)rx_pin;
     rxConfig.clk_div = 80;
-    rxConfig.mem_block_num = 1;
+    rxConfig.mem_block_num = 2;  // Room for a full IR_MAX_PAYLOAD frame
     rxConfig.rx_config.filter_en = true;
     rxConfig.rx_config.filter_ticks_thresh = 100;
     rxConfig.rx_config.idle_threshold = 10000;
     rxConfig.rx_config.rm_carrier = false;
 
     rmt_config(&rxConfig);
-    rmt_driver_install(RMT_CHANNEL_1, 1000, 0); // ring buffer
+    rmt_driver_install(IR_RX_CHANNEL, 1000, 0); // ring buffer
 }
 
-static int decodeIRItems(rmt_item32_t* items, size_t num_items) {
-    for (int i = 0; i <= num_items - 9; i++) {
-        rmt_item32_t start = items[i];
-
-        bool validStart =
-            start.level0 == 0 &&
-            start.level1 == 1 &&
-            (start.duration0 > 1900 && start.duration0 < 2100) &&
-            (start.duration1 > 900  && start.duration1 < 1100);
-
-        if (!validStart) continue;
-
-        uint8_t id = 0;
-        for (int j = 0; j < 8; j++) {
-            rmt_item32_t bit = items[i + j + 1];
-            bool isOne  = (bit.level0 == 1 && bit.level1 == 0);
-            bool isZero = (bit.level0 == 0 && bit.level1 == 1);
-
-            if (!(isOne || isZero)) return -3; // Invalid pulse format
-            if (bit.duration0 < 500 || bit.duration0 > 620 ||
-                bit.duration1 < 500 || bit.duration1 > 620) return -4; // Timing error
-
-            if (isOne) id |= (1 << j); // LSB first
-        }
-
-        return id; // Successfully decoded
-    }
+// Queues the frame and returns immediately, check transmitDone() before the next one
+static bool transmitBeacon(uint8_t channel, const IRBeacon& beacon) {
+    if (channel > 5) return false;
 
-    return -5; // No valid start bit found
-}
+    static rmt_item32_t items[IR_MAX_FRAME_ITEMS]; // Must stay valid while the RMT is sending
+    const uint8_t payload[IR_BEACON_LEN] = { beacon.id, beacon.role };
 
-static int transmitID(uint8_t channel, uint8_t ID) {
-    if (channel > 5) return -1;
+    size_t count = irEncodeFrame(payload, IR_BEACON_LEN, items, IR_MAX_FRAME_ITEMS);
+    if (count == 0) return false;
 
     setChannel(channel);
+    return rmt_write_items(IR_TX_CHANNEL, items, count, false) == ESP_OK;
+}
 
-    rmt_item32_t items[9] = {};
-
-    // Start pulse
-    items[0].level0 = 1;
-    items[0].level1 = 0;
-    items[0].duration0 = 2000;
-    items[0].duration1 = 1000;
-
-    // Data bits
-    for (int i = 0; i < 8; i++) {
-        bool bit = (ID >> i) & 0x01;
-        items[i + 1].level0 = bit ? 0 : 1;
-        items[i + 1].level1 = bit ? 1 : 0;
-        items[i + 1].duration0 = 560;
-        items[i + 1].duration1 = 560;
-    }
-
-    rmt_write_items(RMT_CHANNEL_0, items, 9, true);
-    rmt_wait_tx_done(RMT_CHANNEL_0, pdMS_TO_TICKS(100));
-
-    return 0;
+static bool transmitDone() {
+    return rmt_wait_tx_done(IR_TX_CHANNEL, 0) == ESP_OK;
 }
 
-static int receiveID(uint8_t channel) {
-    if (channel > 5) return -1;
+static void startReceive(uint8_t channel) {
+    if (channel > 5) return;
 
     setChannel(channel);
+    irDecoderReset(&decoder); // Don't stitch frames across directions
+    rmt_rx_start(IR_RX_CHANNEL, true);
+}
 
+// Streams every captured item through the decoder. Returns true if at least
+// one valid beacon completed, the last one is written to beacon.
+static bool pollReceive(IRBeacon* beacon) {
     RingbufHandle_t rb = nullptr;
-    rmt_get_ringbuf_handle(RMT_CHANNEL_1, &rb);
-    rmt_rx_start(RMT_CHANNEL_1, true);
+    rmt_get_ringbuf_handle(IR_RX_CHANNEL, &rb);
+    if (!rb) return false;
 
+    bool found = false;
     size_t length = 0;
-    rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(rb, &length, pdMS_TO_TICKS(RX_TIMEOUT_MS));
-    if (!items || length < sizeof(rmt_item32_t) * 9) {
-        rmt_rx_stop(RMT_CHANNEL_1);
-        return -2; // Timeout or insufficient data
+    rmt_item32_t* items;
+
+    while ((items = (rmt_item32_t*)xRingbufferReceive(rb, &length, 0)) != nullptr) {
+        size_t count = length / sizeof(rmt_item32_t);
+        for (size_t i = 0; i < count; i++) {
+            if (irDecoderFeed(&decoder, items[i]) == IR_BEACON_LEN) {
+                beacon->id = decoder.payload[0];
+                beacon->role = decoder.payload[1];
+                found = true;
+            }
+        }
+        vRingbufferReturnItem(rb, items);
     }
+    return found;
+}
 
-    int id = decodeIRItems(items, length / sizeof(rmt_item32_t));
-    vRingbufferReturnItem(rb, items);
+static void stopReceive() {
+    rmt_rx_stop(IR_RX_CHANNEL);
+}
 
-    rmt_rx_stop(RMT_CHANNEL_1);
-    return id;
+// IR mux channel -> index into state.distances (the ToF mux channel facing
+// the same way), through the per-direction channel order tables
+static int8_t irChannelToDirection(uint8_t channel) {
+    for (uint8_t d = 0; d < IR_DIRECTIONS; d++) {
+        if (ir_ch_order[d] == channel) return tof_ch_order[d];
+    }
+    return -1;
 }
@@ -0,0 +1,129 @@
+#include "kinematics.hpp"
+
+// sin(0..90 deg) in Q15
+static const int16_t SIN_TABLE[91] = {
+        0,   572,  1144,  1715,  2286,  2856,  3425,  3993,  4560,  5126,
+     5690,  6252,  6813,  7371,  7927,  8481,  9032,  9580, 10126, 10668,
+    11207, 11743, 12275, 12803, 13328, 13848, 14364, 14876, 15383, 15886,
+    16383, 16876, 17364, 17846, 18323, 18794, 19260, 19720, 20173, 20621,
+    21062, 21497, 21925, 22347, 22762, 23170, 23571, 23964, 24351, 24730,
+    25101, 25465, 25821, 26169, 26509, 26841, 27165, 27481, 27788, 28087,
+    28377, 28659, 28932, 29196, 29451, 29697, 29934, 30162, 30381, 30591,
+    30791, 30982, 31163, 31335, 31498, 31650, 31794, 31927, 32051, 32165,
+    32269, 32364, 32448, 32523, 32587, 32642, 32687, 32722, 32747, 32762,
+    32767,
+};
+
+// Wheel geometry: left/back wheels see 1/sqrt(3) of vy, right wheel 2/sqrt(3)
+#define INV_SQRT3_Q15 18919
+#define TWO_INV_SQRT3_Q15 37837
+#define SQRT3_DIV6_Q15 9459
+
+// Spin: 14 wheel steps per 9 degrees of body rotation
+#define SPIN_STEPS_NUM 14
+#define SPIN_STEPS_DEN 9
+
+static inline int32_t mulQ15(int32_t a, int32_t q15) {
+    return (int32_t)(((int64_t)a * q15 + (1 << 14)) >> 15); // Rounded
+}
+
+int16_t sinDeg(int32_t deg) {
+    deg %= 360;
+    if (deg < 0) deg += 360;
+
+    if (deg <= 90) return SIN_TABLE[deg];
+    if (deg <= 180) return SIN_TABLE[180 - deg];
+    if (deg <= 270) return -SIN_TABLE[deg - 180];
+    return -SIN_TABLE[360 - deg];
+}
+
+int16_t cosDeg(int32_t deg) {
+    return sinDeg(deg + 90);
+}
+
+int16_t sinMilliDeg(int32_t mdeg) {
+    int32_t deg = mdeg / 1000;
+    int32_t frac = mdeg % 1000;
+    if (frac < 0) {
+        frac += 1000;
+        deg--;
+    }
+
+    int32_t a = sinDeg(deg);
+    int32_t b = sinDeg(deg + 1);
+    return (int16_t)(a + (b - a) * frac / 1000);
+}
+
+int16_t cosMilliDeg(int32_t mdeg) {
+    return sinMilliDeg(mdeg + 90000);
+}
+
+int32_t atan2Deg(int32_t y, int32_t x) {
+    if (x == 0 && y == 0) return 0;
+
+    int64_t ax = llabs((int64_t)x);
+    int64_t ay = llabs((int64_t)y);
+
+    // Reduce to the first octant: find a in 0..45 with tan(a) = small / large
+    bool steep = ay > ax;
+    int64_t small = steep ? ax : ay;
+    int64_t large = steep ? ay : ax;
+
+    // Binary search for the first angle with sin(a) * large >= cos(a) * small
+    int32_t lo = 0, hi = 45;
+    while (lo < hi) {
+        int32_t mid = (lo + hi) / 2;
+        if (SIN_TABLE[mid] * large < SIN_TABLE[90 - mid] * small) lo = mid + 1;
+        else hi = mid;
+    }
+
+    int32_t a = steep ? 90 - lo : lo;   // First quadrant
+    if (x < 0) a = 180 - a;             // Second / third quadrant
+    if (y < 0) a = 360 - a;             // Third / fourth quadrant
+    return a % 360;
+}
+
+WheelSteps bodyToWheels(int32_t vx, int32_t vy, int32_t omegaDeg) {
+    // Rounded instead of truncated, so small spins still move the wheels
+    int32_t spin = omegaDeg * SPIN_STEPS_NUM;
+    spin = (spin >= 0) ? (spin + SPIN_STEPS_DEN / 2) / SPIN_STEPS_DEN
+                       : (spin - SPIN_STEPS_DEN / 2) / SPIN_STEPS_DEN;
+
+    int32_t vyShared = mulQ15(vy, INV_SQRT3_Q15);
+
+    WheelSteps w;
+    w.left = vx - vyShared + spin;
+    w.right = -mulQ15(vy, TWO_INV_SQRT3_Q15) - spin;
+    w.back = vx + vyShared - spin;
+    return w;
+}
+
+WheelSteps bearingToWheels(int32_t bearingDeg, int32_t magnitude, int32_t omegaDeg) {
+    int32_t vx = mulQ15(magnitude, cosDeg(bearingDeg));
+    int32_t vy = mulQ15(magnitude, sinDeg(bearingDeg));
+    return bodyToWheels(vx, vy, omegaDeg);
+}
+
+// Clockwise spin in millidegrees, not narrowed yet
+static int64_t spinMdeg(const WheelSteps& w) {
+    // s = (l - b - r) / 3 wheel steps, SPIN_STEPS_NUM of them per SPIN_STEPS_DEN degrees
+    int64_t spin = ((int64_t)w.left - w.back - w.right) * SPIN_STEPS_DEN * 1000;
+    int64_t den = 3 * SPIN_STEPS_NUM;
+    return (spin >= 0) ? (spin + den / 2) / den : (spin - den / 2) / den;
+}
+
+BodyMotion wheelsToBody(const WheelSteps& w, int32_t unitsPerStep) {
+    // l = vx - vy/sqrt3 + s, r = -2vy/sqrt3 - s, b = vx + vy/sqrt3 - s
+    int64_t l = w.left, r = w.right, b = w.back;
+
+    BodyMotion m;
+    m.vx = (int32_t)((l + b) * unitsPerStep / 2);
+    m.vy = (int32_t)(((b - l - 2 * r) * unitsPerStep * SQRT3_DIV6_Q15 + (1 << 14)) >> 15);
+    m.spinMdeg = (int32_t)spinMdeg(w);
+    return m;
+}
+
+int32_t wheelsToHeadingMdeg(const WheelSteps& w) {
+    int32_t heading = (int32_t)(-(spinMdeg(w) % 360000)); // Spin is clockwise
+    return (heading < 0) ? heading + 360000 : heading;
+}
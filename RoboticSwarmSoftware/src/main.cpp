@@ -5,32 +5,31 @@
 #include "motor_module.hpp"
 #include "network_module.hpp"
 #include "globals.hpp"
+#include "task_stats.hpp"
+#include "config_store.hpp"
 
 // Task handles for control
 TaskHandle_t motorTaskHandle = NULL;
 TaskHandle_t TOFsensorTaskHandle = NULL;
 TaskHandle_t networkTaskHandle = NULL;
 
-TaskHandle_t IRsensorTaskHandle = NULL; //Not-Implemented
+TaskHandle_t IRsensorTaskHandle = NULL;
 
 void setup() {
   Serial.begin(115200);
-  
-  stateMutex = xSemaphoreCreateMutex();
-  
-  if (stateMutex == NULL) {
-    Serial.println("Failed to create mutex!");
-    while (1) delay(1000);
-  }
 
-  connectToHub();
-  setupOTA();
+  // Formation settings from before the reboot, so a brown-out doesn't drop the robot out of formation
+  Config config = Config(); // First boot: OFF with zeroed parameters
+  Serial.println(configStoreLoad(&config) ? "Config restored from NVS" : "No stored config, starting OFF");
+  configLock.write(config);
+
+  // WiFi associates in the background while the hardware comes up
+  startWiFi();
   setupServer();
 
   initMotors(STPR_STEP_1, STPR_STEP_2, STPR_STEP_3, STPR_DIR_1, STPR_DIR_2, STPR_DIR_3);
   initAllToFSensors();
-
-  state.mode = State::OFF;
+  setupIR(IR_MUX_S0, IR_MUX_S1, IR_MUX_S2, IR_Tx, IR_Rx);
 
  // Create tasks pinned to specific cores
   // Core 1 for time-critical motor control
@@ -55,6 +54,17 @@ void setup() {
     1                    // Core 1
   );
   
+  // Core 0 for IR neighbour identification (ms-level TDMA timing)
+  xTaskCreatePinnedToCore(
+    IRsensorTask,
+    "IRSensorTask",
+    4096,
+    NULL,
+    2,                   // Priority (above network, keeps slot timing)
+    &IRsensorTaskHandle,
+    0                    // Core 0
+  );
+  
   // Core 0 for network (lower priority, won't interfere with motors)
   xTaskCreatePinnedToCore(
     networkTask,
@@ -65,6 +75,14 @@ void setup() {
     &networkTaskHandle,
     0                    // Core 0 (where WiFi runs)
   );
+
+  // Stack high-water marks, reported on telemetry/<hostname>/stats
+  taskStatsRegister(motorTaskHandle, "MotorTask", 4096);
+  taskStatsRegister(TOFsensorTaskHandle, "TOFSensorTask", 4096);
+  taskStatsRegister(IRsensorTaskHandle, "IRSensorTask", 4096);
+  taskStatsRegister(networkTaskHandle, "NetworkTask", 8192);
+
+  Serial.printf("Tasks running %lu ms after boot\n", (unsigned long)millis());
 }
 
 void loop() {
@@ -1,75 +1,221 @@
-#include <AccelStepper.h>
+#include <esp_timer.h>
 
 #include "motor_module.hpp"
+#include "motor_command.hpp"
+#include "step_engine.hpp"
+#include "kinematics.hpp"
+#include "odometry.hpp"
+#include "neighbor_fusion.hpp"
 #include "globals.hpp"
-
-AccelStepper* stepperleft = nullptr;
-AccelStepper* stepperright = nullptr;
-AccelStepper* stepperback = nullptr;
+#include "spsc_ring.hpp"
+#include "flight_recorder.hpp"
+#include "task_stats.hpp"
+
+#define MOTOR_MAX_SPEED 1000  // steps/s, no longer bound by the 1 ms task tick
+#define MOTOR_ACCEL 4000      // steps/s^2
+#define MOTOR_JERK 100000     // steps/s^3, full acceleration is reached in 40 ms
+#define POLYGON_SIDES 3       // The polygon planner forms triangles only
+
+// Step engine axis indices, same order as the initMotors pins
+#define AXIS_RIGHT 0
+#define AXIS_LEFT 1
+#define AXIS_BACK 2
+
+static TaskHandle_t plannerTaskHandle = nullptr; // motorTask, target of notifyPlanner
+static volatile uint32_t plannerRuns = 0;
+static volatile uint32_t plannerSaved = 0;
+static volatile FormationRole formationRole = ROLE_NONE;
+static SpscRing<MotorCommand, MOTOR_COMMAND_QUEUE_LEN> commandQueue; // network -> motor
+static Odometry odometry; // Motor task only, published through poseLock
+
+// Commands waiting for their execute time, motor task only. Unordered, it's tiny.
+static MotorCommand scheduled[MOTOR_SCHEDULED_LEN];
+static volatile uint32_t scheduledCount = 0;
+static volatile uint32_t scheduledApplied = 0;
+static volatile uint32_t scheduledLastLateUs = 0;
+static volatile uint32_t scheduledMaxLateUs = 0;
+
+// Step engine positions in setMotorSteps() terms (the left axis runs inverted)
+static WheelSteps wheelPositions(){
+    WheelSteps w;
+    w.left = -stepEnginePosition(AXIS_LEFT);
+    w.right = stepEnginePosition(AXIS_RIGHT);
+    w.back = stepEnginePosition(AXIS_BACK);
+    return w;
+}
 
 //-----------------------------------------------
 // Init Functions
-void setupMotorVar(AccelStepper*& stp, uint8_t step_pin, uint8_t dir_pin, int max_speed, int accel){
-    stp = new AccelStepper(AccelStepper::DRIVER, step_pin, dir_pin); // STEP, DIR
-    stp->setMaxSpeed(max_speed);
-    stp->setAcceleration(accel);
+void initMotors(uint8_t step1, uint8_t step2, uint8_t step3, uint8_t dir1, uint8_t dir2, uint8_t dir3){
+    const uint8_t stepPins[STEP_AXIS_COUNT] = {step1, step2, step3};
+    const uint8_t dirPins[STEP_AXIS_COUNT] = {dir1, dir2, dir3};
+
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        stepEngineSetLimits(i, MOTOR_MAX_SPEED, MOTOR_ACCEL);
+    }
+    stepEngineSetTrajectoryLimits(MOTOR_MAX_SPEED, MOTOR_ACCEL, MOTOR_JERK);
+    initStepEngine(stepPins, dirPins);
+    odometryInit(&odometry, wheelPositions());
 }
 
-void initMotors(uint8_t step1, uint8_t step2, uint8_t step3, uint8_t dir1, uint8_t dir2, uint8_t dir3){
-    setupMotorVar(stepperright, step1, dir1, 300, 4000);
-    setupMotorVar(stepperleft, step2, dir2, 300, 4000);
-    setupMotorVar(stepperback, step3, dir3, 300, 4000);
+//------------------------------------------------
+// Odometry
+static void updatePose(){
+    if (!odometryUpdate(&odometry, wheelPositions())) return;
+
+    static PoseFrame pose = PoseFrame();
+    pose.pose_x = odometry.xUm / 1000;
+    pose.pose_y = odometry.yUm / 1000;
+    pose.pose_heading = (int16_t)(odometry.headingMdeg / 100);
+    pose.pose_seq++;
+    poseLock.write(pose);
+}
+
+//------------------------------------------------
+// Planner Events
+void notifyPlanner(uint32_t events){
+    if (plannerTaskHandle) xTaskNotify(plannerTaskHandle, events, eSetBits);
+}
+
+void getPlannerStats(uint32_t* runs, uint32_t* saved){
+    *runs = plannerRuns;
+    *saved = plannerSaved;
+}
+
+FormationRole getFormationRole(){
+    return formationRole;
+}
+
+// Planner results: -1 = search, -2 = in position, anything else is a move
+static void setFormationRole(int result){
+    formationRole = (result == -1) ? ROLE_SEARCHING : (result == -2) ? ROLE_IN_POSITION : ROLE_MOVING;
+}
+
+//------------------------------------------------
+// Command Queue
+bool enqueueMotorCommand(const MotorCommand& cmd){
+    return commandQueue.push(cmd);
+}
+
+void getCommandQueueStats(uint32_t* depth, uint32_t* maxDepth, uint32_t* dropped){
+    *depth = commandQueue.depth();
+    *maxDepth = commandQueue.maxDepth();
+    *dropped = commandQueue.dropCount();
+}
+
+void getScheduleStats(uint32_t* held, uint32_t* applied, uint32_t* lastLateUs, uint32_t* maxLateUs){
+    *held = scheduledCount;
+    *applied = scheduledApplied;
+    *lastLateUs = scheduledLastLateUs;
+    *maxLateUs = scheduledMaxLateUs;
+}
+
+// The motor task is the only Config writer, so its own last value is always
+// readable. Returns planner events for what changed.
+static uint32_t applyMotorCommand(const MotorCommand& cmd){
+    switch (cmd.type) {
+        case MotorCommand::CONFIG: {
+            Config cfg;
+            if (!configLock.read(cfg)) break;
+            const ParsedCommand& c = cmd.config;
+            if (c.hasMode) cfg.mode = c.mode;
+            if (c.hasNeighborMaxDist) cfg.neighbor_maxDist = c.neighborMaxDist;
+            if (c.hasIdleThresh) cfg.idle_thresh = c.idleThresh;
+            if (c.hasLineNodeDist) cfg.line_nodeDist = c.lineNodeDist;
+            if (c.hasLineAlignTol) cfg.line_alignTol = c.lineAlignTol;
+            if (c.hasPolygonSides) cfg.polygon_sides = POLYGON_SIDES; // Reports the shape that is actually formed
+            if (c.hasPolygonRadius) cfg.polygon_radius = c.polygonRadius;
+            if (c.hasPolygonAlignTol) cfg.polygon_alignTol = c.polygonAlignTol;
+            if (c.hasTofProfile) cfg.tof_profile = c.tofProfile;
+            configLock.write(cfg);
+            return PLANNER_EVENT_CONFIG;
+        }
+        case MotorCommand::MOVE: {
+            Config cfg;
+            if (configLock.read(cfg) && cfg.mode == Config::MANUAL) {
+                setMotorSteps(cmd.left, cmd.right, cmd.back);
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+// Applies held commands whose time has come, earliest first
+static uint32_t applyDueCommands(int64_t now){
+    uint32_t events = 0;
+    while (scheduledCount > 0) {
+        uint32_t next = 0;
+        for (uint32_t i = 1; i < scheduledCount; i++) {
+            if (scheduled[i].executeAtUs < scheduled[next].executeAtUs) next = i;
+        }
+        if (scheduled[next].executeAtUs > now) break;
+
+        events |= applyMotorCommand(scheduled[next]);
+        uint32_t late = (uint32_t)min<int64_t>(now - scheduled[next].executeAtUs, UINT32_MAX);
+        scheduledLastLateUs = late;
+        if (late > scheduledMaxLateUs) scheduledMaxLateUs = late;
+        scheduledApplied++;
+        scheduled[next] = scheduled[--scheduledCount];
+    }
+    return events;
+}
+
+// Applies everything queued so far, in order, except commands with an
+// execute time, which are held until then (or applied this tick if it has
+// already passed, so their lateness is still measured). A full hold list
+// applies the command straight away rather than losing it.
+static uint32_t drainCommandQueue(){
+    uint32_t events = 0;
+    MotorCommand cmd;
+    int64_t now = esp_timer_get_time();
+
+    while (commandQueue.pop(cmd)) {
+        if (cmd.executeAtUs != 0 && scheduledCount < MOTOR_SCHEDULED_LEN) {
+            scheduled[scheduledCount++] = cmd;
+        } else {
+            events |= applyMotorCommand(cmd);
+        }
+    }
+    return events | applyDueCommands(now);
 }
 
 //------------------------------------------------
 // Basic Move Functions
+// All three wheels run one coordinated S-curve trajectory, so they finish
+// together and the base tracks a straight line. A new target blends with the
+// motion in progress instead of restarting the profile; all zero brakes.
 void setMotorSteps(int leftSteps, int rightSteps, int backSteps){
-    if (stepperleft) stepperleft->move(-leftSteps); //Pos Forward - Neg Backward
-    if (stepperright) stepperright->move(rightSteps); //Pos Forward - Neg Backward
-    if (stepperback) stepperback->move(backSteps); //Pos Right - Neg Left
-}
+    recordMotorTarget(leftSteps, rightSteps, backSteps);
 
-void moveMotors(){
-    if(stepperleft) stepperleft->run();
-    if(stepperright) stepperright->run();
-    if(stepperback) stepperback->run();
+    int32_t relative[STEP_AXIS_COUNT];
+    relative[AXIS_LEFT] = -leftSteps; //Pos Forward - Neg Backward
+    relative[AXIS_RIGHT] = rightSteps; //Pos Forward - Neg Backward
+    relative[AXIS_BACK] = backSteps; //Pos Right - Neg Left
+    stepEngineMoveCoordinated(relative);
 }
 
 void stopMotors(){
-    if(stepperleft) stepperleft->stop();
-    if(stepperright) stepperright->stop();
-    if(stepperback) stepperback->stop();
+    stepEngineStopCoordinated();
+}
+
+// Translate along any bearing (sensor i sits at i * 60 deg)
+void moveTowardsBearing(int bearingDeg, int steps){
+    WheelSteps w = bearingToWheels(bearingDeg, steps, 0);
+    setMotorSteps(w.left, w.right, w.back);
 }
 
 void moveTowardsSensori(int i, int steps){
-    switch (i){
-        case 0:
-            setMotorSteps(steps,0,steps);
-            break;
-        case 1:
-            setMotorSteps(0, -steps, steps);
-            break;
-        case 2:
-            setMotorSteps(-steps,-steps,0);
-            break;
-        case 3:
-            setMotorSteps(-steps, 0, -steps);
-            break;
-        case 4:
-            setMotorSteps(0, steps, -steps);
-            break;
-        case 5:
-            setMotorSteps(steps,steps,0);
-            break;
-        default:
-            setMotorSteps(0, 0, 0);
-            break;
+    if (i < 0 || i > 5) {
+        setMotorSteps(0, 0, 0);
+        return;
     }
+    moveTowardsBearing(i * 60, steps);
 }
 
 void spinClockwise(int degrees){
-    int steps = (degrees * 14) / 9;
-    setMotorSteps(steps, -steps, -steps);
+    WheelSteps w = bodyToWheels(0, 0, degrees);
+    setMotorSteps(w.left, w.right, w.back);
 }
 
 //-----------------------------------------------
@@ -77,75 +223,85 @@ void spinClockwise(int degrees){
 
 uint8_t getSensorMask_Idle(State* state) {
     uint8_t mask = 0;
-    int distances[6];  // Local copy of distances
-    int idle_thresh;   // Local copy of threshold
+    int idle_thresh = state->idle_thresh;
 
-    // Acquire mutex to snapshot the data
-    if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(10)) == pdTRUE) {  // Slightly longer timeout; adjust as needed
-        
-        for (int i = 0; i < 6; i++) {
-            distances[i] = state->distances[i];
-        }
-
-        idle_thresh = state->idle_thresh;
-
-        xSemaphoreGive(stateMutex);
-    } else {
-        // Handle failure: e.g., assume all blocked or log error
-        return 0x3F;  // 0b111111, all sensors blocked as a safe default
-    }
-
-    // Now compute safely using local copies (no race possible here)
+    // State is a private snapshot taken by motorTask, no locking needed
     for (int i = 0; i < 6; i++) {
-        if (distances[i] < idle_thresh) {
+        if (!(state->tof_validMask & (1 << i))) continue; // No range, treat as free
+        if ((int)state->distances[i] < idle_thresh) {
             mask |= (1 << i);
         }
     }
     return mask;
 }
 
-int getBestMoveDirection_Idle(uint8_t blockedMask) {
-    int maxFreeLen = 0;
-    int startIdx = -1;
+// Largest circular run of unblocked sensors, as start index and length
+static void findLargestFreeArc(uint8_t blockedMask, int* startIdx, int* maxFreeLen) {
     int freeLen = 0;
     int n = 6; // number of sensors
 
+    *maxFreeLen = 0;
+    *startIdx = -1;
+
     // loop circularly
     for(int i = 0; i < n * 2; i++) {
         int idx = i % n;
         if (!(blockedMask & (1 << idx))) {
             freeLen++;
-            if(freeLen > maxFreeLen) {
-                maxFreeLen = freeLen;
-                startIdx = idx - freeLen + 1;
+            if(freeLen > *maxFreeLen) {
+                *maxFreeLen = freeLen;
+                *startIdx = idx - freeLen + 1;
             }
         } else {
             freeLen = 0;
         }
     }
+}
+
+int getBestMoveDirection_Idle(uint8_t blockedMask) {
+    int startIdx, maxFreeLen;
+    int n = 6;
+    findLargestFreeArc(blockedMask, &startIdx, &maxFreeLen);
 
     // pick center of largest free segment
     return ((startIdx + maxFreeLen / 2) % n + n) % n;
 }
 
+// Exact centre of the largest free segment, can fall between two sensors
+int getBestMoveBearing_Idle(uint8_t blockedMask) {
+    int startIdx, maxFreeLen;
+    findLargestFreeArc(blockedMask, &startIdx, &maxFreeLen);
+
+    int bearing = startIdx * 60 + (maxFreeLen - 1) * 30;
+    return ((bearing % 360) + 360) % 360;
+}
+
+// Valid ToF channels that may be robots: IR fusion drops walls and furniture
+// so formations don't try to space themselves off them
+static uint8_t formationMask(State* state) {
+    ContactType contacts[6];
+    bool irActive = state->ir_cycleSeq >= CONTACT_IR_WARMUP_CYCLES;
+    classifyContacts(state->distances, state->tof_validMask, state->ir_quality,
+                     state->neighbor_ids, state->neighbor_maxDist, irActive, contacts);
+    return state->tof_validMask & ~obstacleMask(contacts);
+}
+
 int getBestMoveDirection_Line(State* state) {
     uint8_t mask = 0;
     int distances[6];
     int neighbor_maxDist, nodeDist, alignTol;
 
-    // Snapshot the state under mutex
-    if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        return -1; // Safe default
-    }
+    // Local copies of the snapshot
     for (int i = 0; i < 6; i++) distances[i] = state->distances[i];
     neighbor_maxDist = state->neighbor_maxDist;
     nodeDist = state->line_nodeDist;
     alignTol = state->line_alignTol;
-    xSemaphoreGive(stateMutex);
 
     // Find the two closest sensors under threshold
+    uint8_t candidates = formationMask(state);
     int first = -1, second = -1;
     for (int i = 0; i < 6; i++) {
+        if (!(candidates & (1 << i))) continue; // Filtered out, no target or not a robot
         if (distances[i] >= neighbor_maxDist) continue;
         if (first == -1 || distances[i] < distances[first]) {
             second = first;
@@ -207,134 +363,106 @@ int getBestMoveDirection_Line(State* state) {
     return -1; // No obstacles
 }
 
-int getBestMoveDirection_Polygon(State* state) {
-    int distances[6];
-    int neighbor_maxDist, radius, alignTol, sides;
+// Smallest signed difference a - b in degrees, -180..179
+static int angleDiff(int a, int b) {
+    int d = (a - b) % 360;
+    if (d < -180) d += 360;
+    if (d >= 180) d -= 360;
+    return d;
+}
 
-    // Snapshot the state under mutex
-    if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        return -1;
-    }
-    for (int i = 0; i < 6; i++) distances[i] = state->distances[i];
-    neighbor_maxDist = state->neighbor_maxDist;
-    radius = state->polygon_radius;
-    alignTol = state->polygon_alignTol;
-    sides = state->polygon_sides;
-    xSemaphoreGive(stateMutex);
+// Body bearing (deg) of a polar map contact, using the heading it was mapped with
+static int contactBodyBearing(State* state, const PolarContact& c) {
+    int deci = c.bearing - state->pose_heading;
+    return (((deci + 5) / 10) % 360 + 360) % 360;
+}
 
-    // Find the (sides - 1) closest neighbors under threshold
-    int first = -1, second = -1;
+// Robots within reach as body bearings and ranges. Ranges always come from
+// this frame, the polar map moves each bearing off the sensor axis to where
+// the sweep centred the robot.
+static int collectNeighbors(State* state, const PolarMap* map, int* bearings, int* distances) {
+    int count = 0;
+    int maxDist = state->neighbor_maxDist;
+
+    PolarContact contacts[POLAR_MAX_CONTACTS];
+    uint8_t n = map ? polarMapContacts(map, contacts, POLAR_MAX_CONTACTS) : 0;
+
+    uint8_t candidates = formationMask(state);
     for (int i = 0; i < 6; i++) {
-        if (distances[i] >= neighbor_maxDist) continue;
-        if (first == -1 || distances[i] < distances[first]) {
-            second = first;
-            first = i;
-        } else if (second == -1 || distances[i] < distances[second]) {
-            second = i;
+        if (!(candidates & (1 << i))) continue; // Filtered out, no target or not a robot
+        if ((int)state->distances[i] >= maxDist) continue;
+
+        // The contact within this sensor's sector, closest to its axis
+        int bearing = i * 60;
+        int bestErr = 31;
+        for (uint8_t c = 0; c < n; c++) {
+            int mapped = contactBodyBearing(state, contacts[c]);
+            int err = abs(angleDiff(mapped, i * 60));
+            if (err < bestErr) {
+                bestErr = err;
+                bearing = mapped;
+            }
         }
+        bearings[count] = bearing;
+        distances[count] = state->distances[i];
+        count++;
     }
+    return count;
+}
+
+// Returns a bearing in degrees (0..359), -1 to search, -2 when in position.
+// Triangle only: both other vertices sit one side away, so every visible
+// neighbour is held at the side distance. Larger N would need to know which
+// neighbours are adjacent and which are diagonals, which fixed sensors and no
+// heading control can't tell reliably.
+int getBestMoveBearing_Polygon(State* state, const PolarMap* map) {
+    int side = state->polygon_radius;
+    int alignTol = state->polygon_alignTol;
+
+    int bearings[POLAR_MAX_CONTACTS];
+    int distances[POLAR_MAX_CONTACTS];
+    int count = collectNeighbors(state, map, bearings, distances);
 
     // ========== CASE: 0 Neighbors ==========
-    if (first == -1) {
+    if (count == 0) {
         return -1; // Search mode
     }
 
-    // ========== CASE: 1 Neighbor ==========
-    if (second == -1) {
-        int idx = first;
-        
-        if (distances[idx] > radius + alignTol) {
-            return idx; // Too far, move toward
-        } else if (distances[idx] < radius - alignTol) {
-            return (idx + 3) % 6; // Too close, move away
-        } else {
-            return -2; // Distance good, stable pair - STOP
+    // Spring model: each neighbour pulls (too far) or pushes (too close)
+    // along its bearing, proportional to its error against the side
+    int64_t fx = 0, fy = 0;
+    bool allInTolerance = true;
+    int worst = 0;
+    int worstErr = 0;
+
+    for (int n = 0; n < count; n++) {
+        int err = distances[n] - side;
+
+        if (abs(err) > alignTol) allInTolerance = false;
+        if (abs(err) > abs(worstErr)) {
+            worstErr = err;
+            worst = n;
         }
+
+        fx += (int64_t)err * cosDeg(bearings[n]);
+        fy += (int64_t)err * sinDeg(bearings[n]);
     }
 
-    // ========== CASE: 2 Neighbors ==========
-    int a = first, b = second;
-    
-    // Calculate angular separation
-    int angularSep = abs(a - b);
-    if (angularSep > 3) angularSep = 6 - angularSep;
-    
-    // Check if neighbors are adjacent (correct for triangle)
-    if (angularSep == 1) {
-        // === Angles CORRECT ===
-        
-        bool aInTolerance = (distances[a] >= radius - alignTol && 
-                             distances[a] <= radius + alignTol);
-        bool bInTolerance = (distances[b] >= radius - alignTol && 
-                             distances[b] <= radius + alignTol);
-        
-        if (aInTolerance && bInTolerance) {
-            return -2; // Perfect triangle - STOP
-        }
-        
-        // Angles correct but distances wrong
-        bool aTooFar = distances[a] > radius + alignTol;
-        bool bTooFar = distances[b] > radius + alignTol;
-        bool aTooClose = distances[a] < radius - alignTol;
-        bool bTooClose = distances[b] < radius - alignTol;
-        
-        if ((aTooFar && bTooFar) || (aTooClose && bTooClose)) {
-            // Both errors in same direction - alternating motion
-            static int toggleCounter = 0;
-            const int TOGGLE_PERIOD = 50;
-            
-            toggleCounter++;
-            if (toggleCounter >= TOGGLE_PERIOD * 2) {
-                toggleCounter = 0;
-            }
-            
-            bool useFirstNeighbor = (toggleCounter < TOGGLE_PERIOD);
-            
-            if (aTooFar && bTooFar) {
-                // Both too far
-                return useFirstNeighbor ? a : b;
-            } else {
-                // Both too close
-                int target = useFirstNeighbor ? a : b;
-                return (target + 3) % 6;
-            }
-        } else {
-            // Mixed errors - prioritize larger error
-            int errorA = abs(distances[a] - radius);
-            int errorB = abs(distances[b] - radius);
-            
-            if (errorA > errorB) {
-                if (aTooFar) return a;
-                else return (a + 3) % 6;
-            } else {
-                if (bTooFar) return b;
-                else return (b + 3) % 6;
-            }
-        }
-    } else if (angularSep == 2) {
-        // === 1 Sensor Gap ===
-        // Find gap sensor and move opposite to it
-        int gapSensor = (a + b) / 2;
-        if (abs(a - b) > 3) {
-            // Handle wrap-around
-            gapSensor = ((a + b + 6) / 2) % 6;
-        }
-        return (gapSensor + 3) % 6; // Move opposite to gap
-        
-    } else if (angularSep == 3) {
-        // === 2 Sensor Gap (Line Formation) ===
-        // We're in the middle of a line, move perpendicular
-        // Choose one of two perpendicular directions consistently
-        return (a + 1) % 6;
-        
-    } else {
-        // Shouldn't happen, but fallback to moving toward midpoint
-        int midpoint = (a + b) / 2;
-        if (abs(a - b) > 3) {
-            midpoint = ((a + b + 6) / 2) % 6;
-        }
-        return midpoint;
+    if (allInTolerance) {
+        return -2; // Every visible vertex one side away - STOP
     }
+
+    // Errors cancelled out, fall back to fixing the worst neighbour
+    if (fx == 0 && fy == 0) {
+        return (worstErr > 0) ? bearings[worst] : (bearings[worst] + 180) % 360;
+    }
+
+    // Keep the full resolution, only scale both down together if they overflow int32
+    while (llabs(fx) > INT32_MAX || llabs(fy) > INT32_MAX) {
+        fx /= 2;
+        fy /= 2;
+    }
+    return atan2Deg((int32_t)fy, (int32_t)fx);
 }
 
 //---------------------------------------------
@@ -344,19 +472,47 @@ void handleIdle(State *state, int stepsToScoot) {
     int numBlocked = __builtin_popcount(blockedMask);
 
     if(numBlocked == 0 || numBlocked == 6) {
+        recordDecision(state->mode, -2, true);
+        setFormationRole(-2);
         setMotorSteps(0, 0, 0);
     } else {
-        int moveDir = getBestMoveDirection_Idle(blockedMask);
-        moveTowardsSensori(moveDir, stepsToScoot);
+        int moveBearing = getBestMoveBearing_Idle(blockedMask);
+        recordDecision(state->mode, moveBearing, true);
+        setFormationRole(moveBearing);
+        moveTowardsBearing(moveBearing, stepsToScoot);
     }
 }
 
-void handleLine(State *state, int stepsToScoot){
+// No neighbour on any sensor axis. If the polar map still holds one between
+// them, turn just far enough to put it on the nearest axis, else spin to search.
+static void searchTurn(State* state, const PolarMap* map) {
+    PolarContact contacts[POLAR_MAX_CONTACTS];
+    uint8_t n = polarMapContacts(map, contacts, POLAR_MAX_CONTACTS);
+    int best = -1;
+    for (uint8_t c = 0; c < n; c++) {
+        if (contacts[c].range >= state->neighbor_maxDist) continue;
+        if (best == -1 || contacts[c].range < contacts[best].range) best = c;
+    }
+    if (best == -1) {
+        spinClockwise(60);
+        return;
+    }
+
+    // A clockwise spin adds to body bearings
+    int bearing = contactBodyBearing(state, contacts[best]);
+    int axis = ((bearing + 30) / 60) * 60;
+    int turn = axis - bearing;
+    spinClockwise(turn ? turn : 60); // Mapped onto an axis yet unseen now: stale, search on
+}
+
+void handleLine(State *state, int stepsToScoot, const PolarMap* map){
     int moveDir = getBestMoveDirection_Line(state);
+    recordDecision(state->mode, moveDir, false);
+    setFormationRole(moveDir);
 
     if(moveDir == -1) {
         // No neighbors detected, search
-        spinClockwise(60);
+        searchTurn(state, map);
     } else if(moveDir == -2) {
         // In position, stop motors
         setMotorSteps(0, 0, 0);
@@ -366,69 +522,102 @@ void handleLine(State *state, int stepsToScoot){
     }
 }
 
-void handlePolygon(State *state, int stepsToScoot){
-    int moveDir = getBestMoveDirection_Polygon(state);
+void handlePolygon(State *state, int stepsToScoot, const PolarMap* map){
+    int moveBearing = getBestMoveBearing_Polygon(state, map);
+    recordDecision(state->mode, moveBearing, true);
+    setFormationRole(moveBearing);
 
-    if(moveDir == -1) {
+    if(moveBearing == -1) {
         // No neighbors detected, search
-        spinClockwise(60);
-    } else if(moveDir == -2) {
+        searchTurn(state, map);
+    } else if(moveBearing == -2) {
         // In position, stop motors
         setMotorSteps(0, 0, 0);
     } else {
-        // Move toward specified direction
-        moveTowardsSensori(moveDir, stepsToScoot);
+        // Move along the resulting bearing
+        moveTowardsBearing(moveBearing, stepsToScoot);
     }
 }
 
 //---------------------------------------------
 // Main function call and FreeRTOS task
-// Called in Task, Regularly updates the target steps for the motors to move towards
-void handleMotors(State *state, int stepsToScoot) {
+// Called by the planner, updates the target steps for the motors to move towards.
+// The step engine executes the current targets between planner runs.
+void handleMotors(State *state, int stepsToScoot, PolarMap* map) {
+    // Every new ToF frame goes into the map at the heading it was taken at
+    if (state->tof_frameSeq != map->frameSeq) {
+        uint8_t targets = formationMask(state);
+        polarMapAddFrame(map, state->distances, targets, state->pose_heading, state->neighbor_maxDist);
+        map->frameSeq = state->tof_frameSeq;
+    }
+
     switch (state->mode) {
         case State::OFF:
+            formationRole = ROLE_NONE;
             setMotorSteps(0, 0, 0);
             break;
         case State::IDLE:
             handleIdle(state, stepsToScoot);
             break;
         case State::LINE:
-            handleLine(state, stepsToScoot);
+            handleLine(state, stepsToScoot, map);
             break;
         case State::POLYGON:
-            handlePolygon(state, stepsToScoot);
+            handlePolygon(state, stepsToScoot, map);
             break;
         case State::MANUAL:
+            formationRole = ROLE_NONE;
             //No Action, Robot Only Moves In Response to Explicit Move Commands
             break;
         default:
             // Optional: handle unexpected state
             break;
     }
-
-    moveMotors();
 }
 
 void motorTask(void* parameter) {
-  const TickType_t xFrequency = pdMS_TO_TICKS(1); // Run every 1ms for smooth motion
+  const TickType_t xFrequency = pdMS_TO_TICKS(1); // 1ms loop, the planner itself only runs on new data
   TickType_t xLastWakeTime = xTaskGetTickCount();
 
-  // Get current state safely
-  State localState;
+  // Private snapshot of config + sensor data, refreshed on every planner run
+  State localState = State();
+  static PolarMap polarMap; // Planner only, kept off the task stack
+  polarMapInit(&polarMap);
+
+  plannerTaskHandle = xTaskGetCurrentTaskHandle();
+  uint32_t lastWakeCycles = cycleCount();
   
   while (true) {
-
-    //If SensorModule has the mutex, this means that it hasn't finished writing
-    //the sensor data to the state, which means the motor should move according
-    //to the last state
-    if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-      localState = state;
-      xSemaphoreGive(stateMutex);
+    uint32_t wakeCycles = cycleCount();
+    latencyRecord(PROBE_MOTOR_PERIOD, wakeCycles - lastWakeCycles);
+    lastWakeCycles = wakeCycles;
+
+    //Collect any events posted since the last tick without blocking the loop
+    uint32_t events = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &events, 0);
+
+    //Commands from the network task take effect before this tick's planner run
+    events |= drainCommandQueue();
+
+    //Dead reckoning follows the wheels every tick, planner run or not
+    updatePose();
+
+    if (events & (PLANNER_EVENT_SENSOR | PLANNER_EVENT_CONFIG)) {
+      //Wait-free read: if a writer is mid-update, that half of the snapshot
+      //keeps its previous contents and the motor moves according to the last state
+      uint32_t start = cycleCount();
+      snapshotState(localState);
+      latencyRecord(PROBE_MOTOR_SNAPSHOT, cycleCount() - start);
+
+      // Re-plan on the new frame / config
+      handleMotors(&localState, 100, &polarMap);
+      latencyRecord(PROBE_MOTOR_PLANNER, cycleCount() - start);
+      plannerRuns++;
+    } else {
+      // Nothing new, the step engine keeps executing the current plan
+      plannerSaved++;
     }
     
-    // Handle motor logic (doesn't need mutex, just reads state)
-    handleMotors(&localState, 100);
-    
     vTaskDelayUntil(&xLastWakeTime, xFrequency);
   }
 }
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include "neighbor_fusion.hpp"
+
+uint8_t classifyContacts(const uint32_t* distances, uint8_t validMask, const uint8_t* irQuality,
+                         const int16_t* neighborIds, uint32_t maxRange, bool irActive, ContactType* out) {
+    uint8_t robots = 0;
+
+    for (int i = 0; i < 6; i++) {
+        if (!(validMask & (1 << i)) || distances[i] >= maxRange) {
+            out[i] = CONTACT_NONE;
+            continue;
+        }
+
+        // Strongest beacon evidence for this direction, neighbours at half weight
+        int quality = irQuality[i];
+        int side = max(irQuality[(i + 1) % 6], irQuality[(i + 5) % 6]) / 2;
+        if (side > quality) quality = side;
+
+        if (neighborIds[i] >= 0 || quality >= CONTACT_ROBOT_QUALITY) {
+            out[i] = CONTACT_ROBOT;
+            robots |= (1 << i);
+        } else if (irActive && quality <= CONTACT_OBSTACLE_QUALITY) {
+            out[i] = CONTACT_OBSTACLE;
+        } else {
+            out[i] = CONTACT_UNKNOWN;
+        }
+    }
+    return robots;
+}
+
+uint8_t obstacleMask(const ContactType* contacts) {
+    uint8_t mask = 0;
+    for (int i = 0; i < 6; i++) {
+        if (contacts[i] == CONTACT_OBSTACLE) mask |= (1 << i);
+    }
+    return mask;
+}
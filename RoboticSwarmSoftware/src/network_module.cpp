@@ -1,17 +1,52 @@
 #include <Wifi.h>
+#include <WiFiUdp.h>
 #include <ArduinoOTA.h>
 #include <ArduinoJson.h>
 #include <PubSubClient.h>
+#include <esp_timer.h>
 
 #include "network_module.hpp"
 #include "network_credentials.hpp"
 #include "motor_module.hpp"
+#include "motor_command.hpp"
+#include "telemetry_frame.hpp"
+#include "command_ingest.hpp"
+#include "flight_recorder.hpp"
+#include "task_stats.hpp"
+#include "status_payload.hpp"
+#include "peer_link.hpp"
+#include "clock_sync.hpp"
+#include "config_store.hpp"
 #include "globals.hpp"
 
 WiFiClient espClient;
 PubSubClient mqttClient(espClient);
+WiFiUDP peerUdp;
 
-String lastReceivedMessage = "";
+static volatile uint8_t telemetryHz = 0; // Binary telemetry rate, 0 = off
+static volatile uint8_t peerHz = PEER_DEFAULT_HZ; // Peer state multicast rate, 0 = listen only
+
+// Neighbour table, owned by networkTask and published through peerLock
+static PeerFrame peerTable = {};
+static bool peerUdpOpen = false;
+
+// Flight recorder dump in progress, one chunk per networkTask iteration
+static uint16_t recorderDumpChunk = 0;
+static uint16_t recorderDumpChunks = 0;
+
+#define RECORDER_TRIGGER_MQTT 1 // FlightRecord arg for triggers sent by the hub
+#define COMMAND_MAX_SCHEDULE_MS 60000 // Further ahead than this is taken as a bad execute_at
+
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 3000 // Cached association gets this long before falling back to a scan
+
+static uint32_t wifiStartMs = 0;
+static bool wifiFastConnect = false; // Current attempt uses the cached BSSID/channel
+static bool wifiWasConnected = false;
+static bool otaStarted = false;
+
+static char clockRequestTopic[64];
+static char clockResponseTopic[64];
+static bool clockShared = false; // clock_synced as last handed to clockLock
 
 //-----------------------------------------------
 // Setup Functions
@@ -50,52 +85,121 @@ void setupOTA() {
   Serial.println("OTA ready");
 }
 
-void connectToHub() {
+// Start associating and return, networkTask finishes the job in serviceWiFi()
+void startWiFi() {
   WiFi.mode(WIFI_STA);
+  WiFi.setHostname(hostname);
   WiFi.setAutoReconnect(true);
-  WiFi.begin(ssid, password);
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
-    // Allow OTA even before WiFi succeeds (if AP comes up later)
-    ArduinoOTA.handle();
+  wifiStartMs = millis();
+
+  WifiCache cache;
+  if (wifiCacheLoad(&cache)) {
+    // Same AP and channel as last time: no scan. The address still comes
+    // from DHCP, a remembered lease may have been handed to someone else.
+    WiFi.begin(ssid, password, cache.channel, cache.bssid);
+    wifiFastConnect = true;
+  } else {
+    WiFi.begin(ssid, password);
+  }
+}
+
+// Called every networkTask loop
+static void serviceWiFi() {
+  bool connected = WiFi.status() == WL_CONNECTED;
+
+  if (connected && !wifiWasConnected) {
+    Serial.printf("WiFi connected in %lu ms (%s), IP ", (unsigned long)(millis() - wifiStartMs), wifiFastConnect ? "cached" : "scan");
+    Serial.println(WiFi.localIP());
+
+    WifiCache cache;
+    memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+    cache.channel = WiFi.channel();
+    wifiCacheSave(cache);
+
+    wifiFastConnect = false;
+    if (!otaStarted) {
+      setupOTA();
+      otaStarted = true;
+    }
   }
-  Serial.println("\nWiFi connected");
-  Serial.print("IP Address: ");
-  Serial.println(WiFi.localIP());
+
+  // Cached association didn't come up (AP moved channel or is gone): forget it and scan
+  if (!connected && wifiFastConnect && millis() - wifiStartMs > WIFI_FAST_CONNECT_TIMEOUT_MS) {
+    Serial.println("Cached WiFi association failed, rescanning");
+    wifiCacheClear();
+    wifiFastConnect = false;
+    WiFi.disconnect();
+    WiFi.begin(ssid, password);
+    wifiStartMs = millis();
+  }
+
+  wifiWasConnected = connected;
+}
+
+// Persist formation settings once the hub has stopped changing them
+static void saveConfigWhenSettled(TickType_t now) {
+  static uint32_t seenVersion = 0;
+  static TickType_t changedAt = 0;
+  static bool dirty = false;
+
+  uint32_t version = configLock.version();
+  if (version != seenVersion) {
+    seenVersion = version;
+    changedAt = now;
+    dirty = true;
+    return;
+  }
+  if (dirty && now - changedAt >= pdMS_TO_TICKS(CONFIG_SAVE_SETTLE_MS)) {
+    Config cfg;
+    if (configLock.read(cfg)) {
+      configStoreSave(cfg);
+      dirty = false;
+    }
+  }
+}
+
+uint8_t getRobotId() {
+  // "esp32_s3_2" -> 2
+  const char* end = hostname + strlen(hostname);
+  const char* p = end;
+  while (p > hostname && isdigit((unsigned char)p[-1])) p--;
+  return (p < end) ? (uint8_t)atoi(p) : 0;
 }
 
 //-----------------------------------------------
 // MQTT Helper & Core Functions
+
+// Hands the current offset estimate to the other tasks (the IR TDMA schedule)
+static void publishClockFrame(int64_t localUs) {
+  ClockSyncStats stats;
+  clockSyncGetStats(&stats, localUs);
+  ClockFrame frame = { stats.synced, stats.offsetUs, stats.accuracyUs };
+  clockLock.write(frame);
+  clockShared = stats.synced;
+}
+
 void mqttCallback(char* topic, byte* payload, unsigned int length) {
-  String message = "";
-  for (unsigned int i = 0; i < length; i++) {
-    message += (char)payload[i];
-  }
-  
-  String topicStr = String(topic);
-  
-  // Check if topic is broadcast or matches my robot ID
-  bool isBroadcast = topicStr.equals("command/broadcast");
-  bool isMyCommand = topicStr.startsWith("command/individual/") && topicStr.endsWith(hostname);
-  
-  if (!isBroadcast && !isMyCommand) {
+  static ReplayWindow replayWindow = {};
+  static uint32_t commandsReplayed = 0;
+  int64_t receivedUs = esp_timer_get_time(); // First thing, t4 for clock sync
+
+  if (strcmp(topic, clockResponseTopic) == 0) {
+    if (clockSyncOnResponse(payload, length, receivedUs)) publishClockFrame(receivedUs);
     return;
   }
-  
-  // Deduplication
-  if (message.equals(lastReceivedMessage)) {
-    Serial.println("Duplicate message, ignoring");
+
+  // Check if topic is broadcast or matches my robot ID
+  if (matchCommandTopic(topic, hostname) == TOPIC_OTHER) {
     return;
   }
-  lastReceivedMessage = message;
   
   Serial.print("Received command: ");
-  Serial.println(message);
+  Serial.write(payload, length);
+  Serial.println();
   
-  // Parse JSON (outside mutex)
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, message);
+  // Parse JSON straight from the payload, no copies on the heap
+  ParsedCommand cmd;
+  DeserializationError error = parseCommand(payload, length, &cmd);
   
   if (error) {
     Serial.print("JSON parse failed: ");
@@ -103,69 +207,78 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
     return;
   }
   
-  // Extract values to local variables (outside mutex)
-  bool hasMode = !doc["mode"].isNull();
-  State::Mode newMode = State::OFF;
-  if (hasMode) {
-    const char* mode = doc["mode"];
-    if (strcmp(mode, "OFF") == 0) newMode = State::OFF;
-    else if (strcmp(mode, "IDLE") == 0) newMode = State::IDLE;
-    else if (strcmp(mode, "LINE") == 0) newMode = State::LINE;
-    else if (strcmp(mode, "POLYGON") == 0) newMode = State::POLYGON;
-    else if (strcmp(mode, "MANUAL") == 0) newMode = State::MANUAL;
+  // Deduplication by sender sequence number (QoS 1 redeliveries, broker replays).
+  // Identical commands with fresh numbers, e.g. the same manual move twice, still run.
+  if (cmd.hasSeq && !replayWindowAccept(&replayWindow, cmd.session, cmd.seq)) {
+    commandsReplayed++;
+    Serial.printf("Replayed command seq %u ignored (%u total)\n", (unsigned)cmd.seq, (unsigned)commandsReplayed);
+    return;
   }
   
-  bool hasNeighborMaxDist = !doc["neighbor_maxDist"].isNull();
-  uint16_t newNeighborMaxDist = hasNeighborMaxDist ? doc["neighbor_maxDist"].as<uint16_t>() : 0;
-  
-  bool hasIdleThresh = !doc["idle_thresh"].isNull();
-  uint16_t newIdleThresh = hasIdleThresh ? doc["idle_thresh"].as<uint16_t>() : 0;
-  
-  bool hasLineNodeDist = !doc["line_nodeDist"].isNull();
-  uint16_t newLineNodeDist = hasLineNodeDist ? doc["line_nodeDist"].as<uint16_t>() : 0;
-  
-  bool hasLineAlignTol = !doc["line_alignTol"].isNull();
-  uint16_t newLineAlignTol = hasLineAlignTol ? doc["line_alignTol"].as<uint16_t>() : 0;
-  
-  bool hasPolygonSides = !doc["polygon_sides"].isNull();
-  uint8_t newPolygonSides = hasPolygonSides ? doc["polygon_sides"].as<uint8_t>() : 0;
+  if (cmd.hasBatchEntry) {
+    Serial.println("Batched command, applying own entry");
+  }
   
-  bool hasPolygonRadius = !doc["polygon_radius"].isNull();
-  uint16_t newPolygonRadius = hasPolygonRadius ? doc["polygon_radius"].as<uint16_t>() : 0;
+  // Binary telemetry rate (network setting, not part of the shared Config)
+  if (cmd.hasTelemetryHz) {
+    telemetryHz = min<uint8_t>(cmd.telemetryHz, TELEMETRY_MAX_HZ);
+  }
+  if (cmd.hasPeerHz) {
+    peerHz = min<uint8_t>(cmd.peerHz, PEER_MAX_HZ);
+  }
   
-  bool hasPolygonAlignTol = !doc["polygon_alignTol"].isNull();
-  uint16_t newPolygonAlignTol = hasPolygonAlignTol ? doc["polygon_alignTol"].as<uint16_t>() : 0;
+  // Flight recorder control, dumping happens from networkTask
+  switch (cmd.recorder) {
+    case RECORDER_TRIGGER:
+      recorderTrigger(RECORDER_TRIGGER_MQTT);
+      break;
+    case RECORDER_DUMP:
+      recorderDumpChunks = recorderStartDump();
+      recorderDumpChunk = 0;
+      break;
+    case RECORDER_ARM:
+      recorderDumpChunks = 0; // Abandon any dump in progress
+      recorderArm();
+      break;
+    default:
+      break;
+  }
   
-  // Manual move commands
-  int l = doc["l"] | 0;
-  int r = doc["r"] | 0;
-  int b = doc["b"] | 0;
-  bool hasManualMove = (l != 0 || r != 0 || b != 0);
+  // Scheduled execution on the shared swarm clock, so every robot switches together
+  int64_t executeAtUs = 0;
+  if (cmd.hasExecuteAt) {
+    if (!clockSyncIsSynced(receivedUs)) {
+      Serial.println("execute_at ignored, clock not synced yet, applying now");
+    } else {
+      executeAtUs = clockSyncSwarmToLocal((int64_t)cmd.executeAtMs * 1000);
+      if (executeAtUs - receivedUs > (int64_t)COMMAND_MAX_SCHEDULE_MS * 1000) {
+        Serial.println("execute_at too far ahead, command dropped");
+        return;
+      }
+    }
+  }
   
-  // NOW take mutex and update state quickly
-  if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-    
-    if (hasMode) state.mode = newMode;
-    if (hasNeighborMaxDist) state.neighbor_maxDist = newNeighborMaxDist;
-    if (hasIdleThresh) state.idle_thresh = newIdleThresh;
-    if (hasLineNodeDist) state.line_nodeDist = newLineNodeDist;
-    if (hasLineAlignTol) state.line_alignTol = newLineAlignTol;
-    if (hasPolygonSides) state.polygon_sides = newPolygonSides;
-    if (hasPolygonRadius) state.polygon_radius = newPolygonRadius;
-    if (hasPolygonAlignTol) state.polygon_alignTol = newPolygonAlignTol;
-    
-    xSemaphoreGive(stateMutex);
-    
-    Serial.println("State updated from MQTT");
-  } else {
-    Serial.println("Failed to acquire mutex for state update");
-    return;
+  // Config and motion are applied by the motor task, in arrival order
+  // (or at executeAtUs)
+  MotorCommand motorCmd = {};
+  motorCmd.executeAtUs = executeAtUs;
+  bool queued = true;
+  if (cmd.hasMode || cmd.hasNeighborMaxDist || cmd.hasIdleThresh || cmd.hasLineNodeDist || cmd.hasLineAlignTol ||
+      cmd.hasPolygonSides || cmd.hasPolygonRadius || cmd.hasPolygonAlignTol || cmd.hasTofProfile) {
+    motorCmd.type = MotorCommand::CONFIG;
+    motorCmd.config = cmd;
+    queued &= enqueueMotorCommand(motorCmd);
   }
   
-  // Execute motor commands AFTER releasing mutex
-  if (newMode == State::MANUAL && hasManualMove) {
-    setMotorSteps(l, r, b);
+  if (cmd.hasManualMove) {
+    motorCmd.type = MotorCommand::MOVE;
+    motorCmd.left = cmd.l;
+    motorCmd.right = cmd.r;
+    motorCmd.back = cmd.b;
+    queued &= enqueueMotorCommand(motorCmd);
   }
+  
+  Serial.println(queued ? "Command queued for motor task" : "Motor command queue full, command dropped");
 }
 
 void mqttReconnect() {
@@ -183,6 +296,7 @@ void mqttReconnect() {
 
       mqttClient.subscribe("command/broadcast");
       mqttClient.subscribe(commandTopic);
+      mqttClient.subscribe(clockResponseTopic);
 
       const char* pubConMsg = "Connected to MQTT";
       mqttClient.publish(statusTopic, pubConMsg);
@@ -194,75 +308,72 @@ void mqttReconnect() {
   }
 }
 
-void buildStatusPayload(char* buffer, size_t bufferSize) {
-  // Local copies of state variables
-  State::Mode mode;
-  uint16_t neighbor_maxDist;
-  uint16_t idle_thresh;
-  uint16_t line_nodeDist, line_alignTol;
-  uint8_t polygon_sides;
-  uint16_t polygon_radius, polygon_alignTol;
-  uint32_t distances[6];
-  
-  // Take mutex, copy data, release immediately
-  if(xSemaphoreTake(stateMutex, portMAX_DELAY) == pdTRUE) {
-    mode = state.mode;
-    neighbor_maxDist = state.neighbor_maxDist;
-    idle_thresh = state.idle_thresh;
-    line_nodeDist = state.line_nodeDist;
-    line_alignTol = state.line_alignTol;
-    polygon_sides = state.polygon_sides;
-    polygon_radius = state.polygon_radius;
-    polygon_alignTol = state.polygon_alignTol;
-    memcpy(distances, state.distances, sizeof(distances));
-    
-    xSemaphoreGive(stateMutex);
-  }
-  
-  // Build JSON with ArduinoJson
-  JsonDocument doc;
-  
-  // Mode as string
-  const char* modeStr;
-  switch(mode) {
-    case State::OFF: modeStr = "OFF"; break;
-    case State::IDLE: modeStr = "IDLE"; break;
-    case State::LINE: modeStr = "LINE"; break;
-    case State::POLYGON: modeStr = "POLYGON"; break;
-    case State::MANUAL: modeStr = "MANUAL"; break;
-    default: modeStr = "UNKNOWN"; break;
-  }
-  doc["mode"] = modeStr;
-  
-  // General parameters
-  doc["neighbor_maxDist"] = neighbor_maxDist;
-  
-  // Mode-specific parameters
-  switch(mode) {
-    case State::IDLE:
-      doc["idle_thresh"] = idle_thresh;
-      break;
-    case State::LINE:
-      doc["line_nodeDist"] = line_nodeDist;
-      doc["line_alignTol"] = line_alignTol;
-      break;
-    case State::POLYGON:
-      doc["polygon_sides"] = polygon_sides;
-      doc["polygon_radius"] = polygon_radius;
-      doc["polygon_alignTol"] = polygon_alignTol;
-      break;
-    default:
-      break;
+// Fixed-size binary frame, no JSON document involved
+static void publishTelemetryFrame(const char* topic) {
+  static State snapshot = State();
+  static uint32_t telemetrySeq = 0;
+  TelemetryFrame frame;
+  uint32_t runs, saved;
+
+  snapshotState(snapshot);
+  getPlannerStats(&runs, &saved);
+  buildTelemetryFrame(&frame, snapshot, getRobotId(), telemetrySeq++, millis(), runs, saved);
+
+  mqttClient.publish(topic, (const uint8_t*)&frame, sizeof(frame));
+}
+
+// One clock sync round trip, the hub's answer arrives in mqttCallback
+static void sendClockRequest() {
+  ClockRequest request;
+  clockSyncBuildRequest(&request, getRobotId(), esp_timer_get_time());
+  mqttClient.publish(clockRequestTopic, (const uint8_t*)&request, sizeof(request));
+}
+
+// Publishes the next chunk of a flight recorder dump, if one is in progress.
+// A chunk is ~650 bytes; one per call keeps each networkTask loop short.
+static void publishRecorderChunk(const char* topic) {
+  static uint8_t chunk[RECORDER_CHUNK_BYTES];
+
+  if (recorderDumpChunk >= recorderDumpChunks) return;
+
+  size_t size = recorderReadChunk(recorderDumpChunk, chunk, sizeof(chunk));
+  if (size == 0 || mqttClient.publish(topic, chunk, size)) {
+    recorderDumpChunk++; // Skip unreadable chunks, retry failed publishes next loop
   }
-  
-  // Distance array
-  JsonArray distArray = doc["distances"].to<JsonArray>();
-  for (int i = 0; i < 6; i++) {
-    distArray.add(distances[i]);
+}
+
+//-----------------------------------------------
+// Peer Link (UDP multicast, robot to robot)
+static void sendPeerState() {
+  static State snapshot = State();
+  static uint16_t peerSeq = 0;
+  PeerPacket packet;
+
+  snapshotState(snapshot);
+  buildPeerPacket(&packet, snapshot, getRobotId(), getFormationRole(), peerHz, peerSeq++);
+
+  peerUdp.beginPacket(IPAddress(PEER_GROUP_IP), PEER_PORT);
+  peerUdp.write((const uint8_t*)&packet, sizeof(packet));
+  peerUdp.endPacket();
+}
+
+// Drains every waiting datagram, ages the table and publishes it if anything changed
+static void receivePeerStates() {
+  uint8_t buffer[sizeof(PeerPacket) + 1]; // One spare byte so oversized datagrams fail the length check
+  PeerPacket packet;
+  uint32_t now = millis();
+  bool changed = false;
+
+  while (peerUdp.parsePacket() > 0) {
+    int length = peerUdp.read(buffer, sizeof(buffer));
+    if (length <= 0 || !parsePeerPacket(buffer, length, &packet)) continue;
+    if (packet.robotId == getRobotId()) continue; // Our own multicast looped back
+    peerTableUpdate(&peerTable, packet, now);
+    changed = true;
   }
-  
-  // Serialize to buffer
-  serializeJson(doc, buffer, bufferSize);
+
+  if (peerTableAge(&peerTable, now) > 0) changed = true;
+  if (changed) peerLock.write(peerTable);
 }
 
 //-----------------------------------------------
@@ -270,8 +381,13 @@ void buildStatusPayload(char* buffer, size_t bufferSize) {
 void setupServer() {
   mqttClient.setServer(mqtt_broker, mqtt_port);
   mqttClient.setCallback(mqttCallback);
-
-  mqttReconnect();
+  mqttClient.setBufferSize(2048); // Status/stats JSON, recorder chunks and batched commands exceed the 256 byte default
+  if (!setCommandAddress(hostname, getRobotId())) { // Our key in batched commands
+    Serial.println("Command filter overflowed its arena, batched commands are ignored");
+  }
+  snprintf(clockRequestTopic, sizeof(clockRequestTopic), "clock/%s/req", hostname);
+  snprintf(clockResponseTopic, sizeof(clockResponseTopic), "clock/%s/resp", hostname);
+  // MQTT connects from networkTask once WiFi is up
 }
 
 // FreeRTOS Task
@@ -280,27 +396,87 @@ void networkTask(void* parameter) {
 
   TickType_t lastStatusPublish = 0;
   const TickType_t STATUS_PUBLISH_INTERVAL = pdMS_TO_TICKS(1000); // Publish status every 1 second
+  TickType_t lastTelemetryPublish = 0;
+  TickType_t lastStatsPublish = 0;
+  const TickType_t STATS_PUBLISH_INTERVAL = pdMS_TO_TICKS(5000);
+  TickType_t lastPeerSend = 0;
+  TickType_t lastClockRequest = 0;
+
+  char statusTopici[100];
+  char telemetryTopic[100];
+  char recorderTopic[100];
+  char statsTopic[100];
+  snprintf(statusTopici, sizeof(statusTopici), "telemetry/%s/status", (char*)hostname);
+  snprintf(telemetryTopic, sizeof(telemetryTopic), "telemetry/%s/bin", (char*)hostname);
+  snprintf(recorderTopic, sizeof(recorderTopic), "telemetry/%s/recorder", (char*)hostname);
+  snprintf(statsTopic, sizeof(statsTopic), "telemetry/%s/stats", (char*)hostname);
 
   while (true) {
-      ArduinoOTA.handle();
-      if(!mqttClient.connected()) {
+      uint32_t loopStart = cycleCount();
+      TickType_t now = xTaskGetTickCount();
+
+      serviceWiFi();
+      if (otaStarted) {
+        ArduinoOTA.handle();
+      }
+      if (WiFi.status() == WL_CONNECTED && !mqttClient.connected()) {
         mqttReconnect();
       }
       mqttClient.loop();
 
+      saveConfigWhenSettled(now);
+
+      // Peer states straight between robots, independent of the broker
+      if (!peerUdpOpen && WiFi.status() == WL_CONNECTED) {
+          peerUdpOpen = peerUdp.beginMulticast(IPAddress(PEER_GROUP_IP), PEER_PORT);
+      }
+      if (peerUdpOpen) {
+          receivePeerStates();
+          uint8_t rate = peerHz;
+          if (rate > 0 && now - lastPeerSend >= pdMS_TO_TICKS(1000 / rate)) {
+              sendPeerState();
+              lastPeerSend = now;
+          }
+      }
+
       // Only publish status periodically
-      TickType_t now = xTaskGetTickCount();
       if (now - lastStatusPublish >= STATUS_PUBLISH_INTERVAL) {
-          char statusTopici[100];
-          snprintf(statusTopici, sizeof(statusTopici), "telemetry/%s/status", (char*)hostname);
-          
-          char statusData[512];
+          static char statusData[1024];
           buildStatusPayload(statusData, sizeof(statusData));
           
           mqttClient.publish(statusTopici, statusData);
           lastStatusPublish = now;
       }
 
+      // Binary telemetry at control-loop rates, telemetry_hz command sets the period
+      uint8_t hz = telemetryHz;
+      if (hz > 0 && mqttClient.connected() && now - lastTelemetryPublish >= pdMS_TO_TICKS(1000 / hz)) {
+          publishTelemetryFrame(telemetryTopic);
+          lastTelemetryPublish = now;
+      }
+
+      if (mqttClient.connected()) {
+          publishRecorderChunk(recorderTopic);
+      }
+
+      // Clock sync, quick rounds until the estimate settles then every few seconds
+      if (mqttClient.connected() && now - lastClockRequest >= pdMS_TO_TICKS(clockSyncRequestPeriodMs())) {
+          sendClockRequest();
+          lastClockRequest = now;
+      }
+      if (clockShared && !clockSyncIsSynced(esp_timer_get_time())) {
+          publishClockFrame(esp_timer_get_time()); // Estimate went stale, don't let others trust it
+      }
+
+      if (now - lastStatsPublish >= STATS_PUBLISH_INTERVAL) {
+          static char statsData[1536];
+          buildStatsPayload(statsData, sizeof(statsData));
+          mqttClient.publish(statsTopic, statsData);
+          lastStatsPublish = now;
+      }
+
+      latencyRecord(PROBE_NET_LOOP, cycleCount() - loopStart);
+
       vTaskDelay(xFrequency);
   }
 }
\ No newline at end of file
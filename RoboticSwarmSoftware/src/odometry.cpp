@@ -0,0 +1,39 @@
+#include "odometry.hpp"
+
+void odometryInit(Odometry* o, const WheelSteps& wheels) {
+    o->origin = wheels;
+    o->last = wheels;
+    o->xUm = 0;
+    o->yUm = 0;
+    o->headingMdeg = 0;
+}
+
+bool odometryUpdate(Odometry* o, const WheelSteps& wheels) {
+    WheelSteps delta;
+    delta.left = wheels.left - o->last.left;
+    delta.right = wheels.right - o->last.right;
+    delta.back = wheels.back - o->last.back;
+    if (delta.left == 0 && delta.right == 0 && delta.back == 0) return false;
+    o->last = wheels;
+
+    // Heading from the total travel since init, so rounding never accumulates
+    WheelSteps total;
+    total.left = wheels.left - o->origin.left;
+    total.right = wheels.right - o->origin.right;
+    total.back = wheels.back - o->origin.back;
+    int32_t heading = wheelsToHeadingMdeg(total);
+
+    // Rotate this tick's body displacement by the mid-tick heading
+    int32_t turn = heading - o->headingMdeg;
+    if (turn > 180000) turn -= 360000;
+    if (turn < -180000) turn += 360000;
+    int32_t mid = o->headingMdeg + turn / 2;
+
+    BodyMotion m = wheelsToBody(delta, ODOM_UM_PER_STEP);
+    int32_t c = cosMilliDeg(mid);
+    int32_t s = sinMilliDeg(mid);
+    o->xUm += (int32_t)(((int64_t)m.vx * c - (int64_t)m.vy * s + (1 << 14)) >> 15);
+    o->yUm += (int32_t)(((int64_t)m.vx * s + (int64_t)m.vy * c + (1 << 14)) >> 15);
+    o->headingMdeg = heading;
+    return true;
+}
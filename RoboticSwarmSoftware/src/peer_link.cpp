@@ -0,0 +1,78 @@
+#include "peer_link.hpp"
+
+#define PEER_RESTART_GAP 1000 // Larger forward jumps (or any step back) mean the sender rebooted
+
+void buildPeerPacket(PeerPacket* packet, const State& state, uint8_t robotId, uint8_t role, uint8_t hz, uint16_t seq) {
+    packet->magic = PEER_MAGIC;
+    packet->version = PEER_VERSION;
+    packet->robotId = robotId;
+    packet->mode = (uint8_t)state.mode;
+    packet->role = role;
+    packet->tofValidMask = state.tof_validMask;
+    packet->hz = hz;
+    packet->seq = seq;
+    for (int i = 0; i < 6; i++) {
+        packet->distances[i] = (state.distances[i] > 0xFFFF) ? 0xFFFF : (uint16_t)state.distances[i];
+    }
+}
+
+bool parsePeerPacket(const uint8_t* data, size_t length, PeerPacket* out) {
+    if (length != sizeof(PeerPacket)) return false;
+    memcpy(out, data, sizeof(PeerPacket));
+    return out->magic == PEER_MAGIC && out->version == PEER_VERSION && out->robotId != 0;
+}
+
+static uint32_t peerTimeout(uint8_t hz) {
+    if (hz == 0) hz = 1;
+    return max<uint32_t>(PEER_TIMEOUT_PERIODS * 1000 / hz, PEER_MIN_TIMEOUT_MS);
+}
+
+void peerTableUpdate(PeerFrame* table, const PeerPacket& packet, uint32_t nowMs) {
+    PeerEntry* entry = const_cast<PeerEntry*>(peerTableFind(*table, packet.robotId));
+
+    if (entry) {
+        uint16_t gap = (uint16_t)(packet.seq - entry->seq);
+        if (gap == 0) return; // Duplicate
+        if (gap < PEER_RESTART_GAP) entry->lost += gap - 1;
+    } else {
+        if (table->count < PEER_TABLE_SIZE) {
+            entry = &table->peers[table->count++];
+        } else {
+            // Evict whoever we heard from least recently
+            entry = &table->peers[0];
+            for (uint8_t i = 1; i < table->count; i++) {
+                if (nowMs - table->peers[i].lastHeardMs > nowMs - entry->lastHeardMs) entry = &table->peers[i];
+            }
+        }
+        memset(entry, 0, sizeof(*entry));
+    }
+
+    entry->robotId = packet.robotId;
+    entry->mode = packet.mode;
+    entry->role = packet.role;
+    entry->tof_validMask = packet.tofValidMask;
+    memcpy(entry->distances, packet.distances, sizeof(entry->distances));
+    entry->seq = packet.seq;
+    entry->lastHeardMs = nowMs;
+    entry->timeoutMs = peerTimeout(packet.hz);
+}
+
+uint8_t peerTableAge(PeerFrame* table, uint32_t nowMs) {
+    uint8_t removed = 0;
+    for (uint8_t i = 0; i < table->count;) {
+        if (nowMs - table->peers[i].lastHeardMs > table->peers[i].timeoutMs) {
+            table->peers[i] = table->peers[--table->count]; // Order doesn't matter, keep it dense
+            removed++;
+        } else {
+            i++;
+        }
+    }
+    return removed;
+}
+
+const PeerEntry* peerTableFind(const PeerFrame& table, uint8_t robotId) {
+    for (uint8_t i = 0; i < table.count; i++) {
+        if (table.peers[i].robotId == robotId) return &table.peers[i];
+    }
+    return nullptr;
+}
@@ -0,0 +1,86 @@
+#include "polar_map.hpp"
+
+void polarMapInit(PolarMap* map) {
+    memset(map, 0, sizeof(*map));
+}
+
+// Bin holding a world bearing in tenths of a degree
+static inline uint8_t binOf(int32_t deci) {
+    deci %= 3600;
+    if (deci < 0) deci += 3600;
+    return (uint8_t)(deci / (POLAR_BIN_DEG * 10));
+}
+
+void polarMapAddFrame(PolarMap* map, const uint32_t* distances, uint8_t targetMask,
+                      int16_t headingDeci, uint32_t maxRange) {
+    // Rounded up so weights fade all the way to zero
+    for (uint8_t b = 0; b < POLAR_BINS; b++) {
+        uint8_t w = map->bins[b].weight;
+        map->bins[b].weight = w - ((w + (1 << POLAR_DECAY_SHIFT) - 1) >> POLAR_DECAY_SHIFT);
+    }
+
+    for (uint8_t i = 0; i < 6; i++) {
+        PolarBin& bin = map->bins[binOf(headingDeci + i * 600)];
+
+        if ((targetMask & (1 << i)) && distances[i] < maxRange) {
+            uint16_t range = (uint16_t)distances[i];
+            bin.range = bin.weight ? (uint16_t)((bin.range + range + 1) / 2) : range;
+            bin.weight = (uint8_t)min(255, bin.weight + POLAR_HIT_WEIGHT);
+        } else {
+            bin.weight >>= 1; // Clear line of sight, or only a wall there
+        }
+    }
+}
+
+// Bins a and b (neighbours) belong to the same contact
+static inline bool sameContact(const PolarBin& a, const PolarBin& b) {
+    return a.weight >= POLAR_MIN_WEIGHT && b.weight >= POLAR_MIN_WEIGHT &&
+           abs((int)a.range - (int)b.range) <= POLAR_RANGE_GAP;
+}
+
+uint8_t polarMapContacts(const PolarMap* map, PolarContact* out, uint8_t maxOut) {
+    // Start the scan where a contact begins, so none is split across the wrap
+    int start = -1;
+    for (int b = 0; b < POLAR_BINS && start < 0; b++) {
+        const PolarBin& bin = map->bins[b];
+        const PolarBin& prev = map->bins[(b + POLAR_BINS - 1) % POLAR_BINS];
+        if (bin.weight >= POLAR_MIN_WEIGHT && !sameContact(prev, bin)) start = b;
+    }
+    if (start < 0) {
+        if (map->bins[0].weight < POLAR_MIN_WEIGHT) return 0; // Empty
+        start = 0; // One ring all the way round
+    }
+
+    uint8_t count = 0;
+    int b = start;
+    for (int scanned = 0; scanned < POLAR_BINS && count < maxOut;) {
+        if (map->bins[b].weight < POLAR_MIN_WEIGHT) {
+            b = (b + 1) % POLAR_BINS;
+            scanned++;
+            continue;
+        }
+
+        // Weighted centre of the run, in bins from its first one
+        uint32_t weightSum = 0, offsetSum = 0;
+        uint8_t strongest = b, len = 0;
+        int first = b;
+        do {
+            const PolarBin& bin = map->bins[b];
+            weightSum += bin.weight;
+            offsetSum += (uint32_t)len * bin.weight;
+            if (bin.weight > map->bins[strongest].weight) strongest = b;
+            len++;
+            b = (b + 1) % POLAR_BINS;
+            scanned++;
+        } while (scanned < POLAR_BINS && sameContact(map->bins[(b + POLAR_BINS - 1) % POLAR_BINS], map->bins[b]));
+
+        PolarContact& c = out[count++];
+        int32_t centre = first * POLAR_BIN_DEG * 10 + POLAR_BIN_DEG * 5 +
+                         (int32_t)(offsetSum * POLAR_BIN_DEG * 10 / weightSum);
+        c.bearing = (int16_t)(centre % 3600);
+        c.range = map->bins[strongest].range;
+        c.weight = map->bins[strongest].weight;
+        c.bins = len;
+    }
+    return count;
+}
@@ -0,0 +1,197 @@
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+
+#include "status_payload.hpp"
+#include "motor_module.hpp"
+#include "task_stats.hpp"
+#include "clock_sync.hpp"
+#include "tof_profiles.hpp"
+#include "globals.hpp"
+
+// Latency histograms and stack marks. Counts are cumulative since boot,
+// the host diffs consecutive reports for a windowed view.
+void buildStatsPayload(char* buffer, size_t bufferSize) {
+  JsonDocument doc;
+  
+  doc["uptime_ms"] = millis();
+  doc["cpu_mhz"] = getCpuFrequencyMhz();
+  
+  // Only the occupied bucket range: "b0" is the first bucket index,
+  // bucket b holds durations of 2^b .. 2^(b+1)-1 cycles
+  JsonObject probes = doc["probes"].to<JsonObject>();
+  for (uint8_t p = 0; p < PROBE_COUNT; p++) {
+    const LatencyHistogram& h = latencyHistograms[p];
+    int first = 0, last = -1;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+      if (h.buckets[b] == 0) continue;
+      if (last < 0) first = b;
+      last = b;
+    }
+    
+    JsonObject probe = probes[latencyProbeName((LatencyProbe)p)].to<JsonObject>();
+    probe["n"] = h.count;
+    probe["max"] = h.maxCycles;
+    probe["b0"] = first;
+    JsonArray hist = probe["hist"].to<JsonArray>();
+    for (int b = first; b <= last; b++) {
+      hist.add(h.buckets[b]);
+    }
+  }
+  
+  JsonObject stacks = doc["stack"].to<JsonObject>();
+  for (uint8_t i = 0; i < taskStatsTaskCount(); i++) {
+    const char* name;
+    uint32_t stackBytes, minFree;
+    taskStatsGetTask(i, &name, &stackBytes, &minFree);
+    JsonObject task = stacks[name].to<JsonObject>();
+    task["size"] = stackBytes;
+    task["min_free"] = minFree;
+  }
+  
+  serializeJson(doc, buffer, bufferSize);
+}
+
+void buildStatusPayload(char* buffer, size_t bufferSize) {
+  // Local copies of state variables
+  State::Mode mode;
+  uint16_t neighbor_maxDist;
+  uint16_t idle_thresh;
+  uint16_t line_nodeDist, line_alignTol;
+  uint8_t polygon_sides;
+  uint16_t polygon_radius, polygon_alignTol;
+  uint32_t distances[6];
+  int16_t neighborIds[6];
+  uint8_t neighborRoles[6];
+  uint8_t irQuality[6];
+  uint32_t plannerRuns, plannerSaved;
+  uint32_t queueDepth, queueMaxDepth, queueDropped;
+  
+  // Wait-free snapshot; if a writer is mid-update the previous values are kept
+  static State snapshot = State();
+  snapshotState(snapshot);
+
+  mode = snapshot.mode;
+  neighbor_maxDist = snapshot.neighbor_maxDist;
+  idle_thresh = snapshot.idle_thresh;
+  line_nodeDist = snapshot.line_nodeDist;
+  line_alignTol = snapshot.line_alignTol;
+  polygon_sides = snapshot.polygon_sides;
+  polygon_radius = snapshot.polygon_radius;
+  polygon_alignTol = snapshot.polygon_alignTol;
+  memcpy(distances, snapshot.distances, sizeof(distances));
+  memcpy(neighborIds, snapshot.neighbor_ids, sizeof(neighborIds));
+  memcpy(neighborRoles, snapshot.neighbor_roles, sizeof(neighborRoles));
+  memcpy(irQuality, snapshot.ir_quality, sizeof(irQuality));
+  getPlannerStats(&plannerRuns, &plannerSaved);
+  getCommandQueueStats(&queueDepth, &queueMaxDepth, &queueDropped);
+  
+  // Build JSON with ArduinoJson
+  JsonDocument doc;
+  
+  // Mode as string
+  const char* modeStr;
+  switch(mode) {
+    case State::OFF: modeStr = "OFF"; break;
+    case State::IDLE: modeStr = "IDLE"; break;
+    case State::LINE: modeStr = "LINE"; break;
+    case State::POLYGON: modeStr = "POLYGON"; break;
+    case State::MANUAL: modeStr = "MANUAL"; break;
+    default: modeStr = "UNKNOWN"; break;
+  }
+  doc["mode"] = modeStr;
+  
+  // General parameters
+  doc["neighbor_maxDist"] = neighbor_maxDist;
+  
+  // Mode-specific parameters
+  switch(mode) {
+    case State::IDLE:
+      doc["idle_thresh"] = idle_thresh;
+      break;
+    case State::LINE:
+      doc["line_nodeDist"] = line_nodeDist;
+      doc["line_alignTol"] = line_alignTol;
+      break;
+    case State::POLYGON:
+      doc["polygon_sides"] = polygon_sides;
+      doc["polygon_radius"] = polygon_radius;
+      doc["polygon_alignTol"] = polygon_alignTol;
+      break;
+    default:
+      break;
+  }
+  
+  // Distance array
+  JsonArray distArray = doc["distances"].to<JsonArray>();
+  for (int i = 0; i < 6; i++) {
+    distArray.add(distances[i]);
+  }
+
+  // Neighbour IDs heard over IR, same order as distances (-1 = none)
+  JsonArray idArray = doc["neighbor_ids"].to<JsonArray>();
+  for (int i = 0; i < 6; i++) {
+    idArray.add(neighborIds[i]);
+  }
+
+  // Formation role each of those neighbours announced (FormationRole, 0 = none)
+  JsonArray roleArray = doc["neighbor_roles"].to<JsonArray>();
+  for (int i = 0; i < 6; i++) {
+    roleArray.add(neighborRoles[i]);
+  }
+
+  // IR detection quality per direction, 0..255
+  JsonArray qualityArray = doc["ir_quality"].to<JsonArray>();
+  for (int i = 0; i < 6; i++) {
+    qualityArray.add(irQuality[i]);
+  }
+
+  // Ranging profile: requested (may be auto), running, and the frame rate it gives
+  JsonObject tofObj = doc["tof"].to<JsonObject>();
+  tofObj["profile"] = TOF_PROFILES[snapshot.tof_profile < TOF_PROFILE_COUNT ? snapshot.tof_profile : 0].name;
+  tofObj["active"] = TOF_PROFILES[snapshot.tof_activeProfile < TOF_PROFILE_COUNT ? snapshot.tof_activeProfile : 0].name;
+  tofObj["hz"] = snapshot.tof_rateX10 / 10.0f;
+
+  // Dead-reckoned pose since power-on, heading in degrees counter-clockwise
+  JsonObject poseObj = doc["pose"].to<JsonObject>();
+  poseObj["x"] = snapshot.pose_x;
+  poseObj["y"] = snapshot.pose_y;
+  poseObj["heading"] = snapshot.pose_heading / 10.0f;
+
+  // Swarm clock sync and how closely scheduled commands hit their time
+  ClockSyncStats clock;
+  clockSyncGetStats(&clock, esp_timer_get_time());
+  JsonObject clockObj = doc["clock"].to<JsonObject>();
+  clockObj["synced"] = clock.synced;
+  clockObj["offset_us"] = clock.offsetUs;
+  clockObj["accuracy_us"] = clock.accuracyUs;
+  clockObj["rtt_us"] = clock.lastRoundTripUs;
+  clockObj["samples"] = clock.samples;
+
+  uint32_t held, applied, lastLateUs, maxLateUs;
+  getScheduleStats(&held, &applied, &lastLateUs, &maxLateUs);
+  JsonObject schedObj = doc["sched"].to<JsonObject>();
+  schedObj["held"] = held;
+  schedObj["applied"] = applied;
+  schedObj["late_us"] = lastLateUs;
+  schedObj["max_late_us"] = maxLateUs;
+
+  // Robots heard over the UDP peer link
+  static PeerFrame peers = {};
+  peerLock.read(peers);
+  JsonArray peerArray = doc["peers"].to<JsonArray>();
+  for (uint8_t i = 0; i < peers.count; i++) {
+    peerArray.add(peers.peers[i].robotId);
+  }
+
+  // Planner activity (runs vs. 1ms ticks skipped for lack of new data)
+  doc["planner_runs"] = plannerRuns;
+  doc["planner_saved"] = plannerSaved;
+
+  // Network -> motor command queue
+  doc["cmdq_depth"] = queueDepth;
+  doc["cmdq_max_depth"] = queueMaxDepth;
+  doc["cmdq_dropped"] = queueDropped;
+  
+  // Serialize to buffer
+  serializeJson(doc, buffer, bufferSize);
+}
@@ -0,0 +1,301 @@
+#include "step_engine.hpp"
+#include "soc/gpio_reg.h"
+#include "task_stats.hpp"
+#include "trajectory.hpp"
+
+#define TRAJ_TICK_DIVIDER (STEP_TICK_HZ / TRAJ_UPDATE_HZ)
+
+//-------------------------
+// Axis State
+//-------------------------
+// Speeds are phase increments: a 32-bit accumulator wraps once per step, so
+// rate = steps/s * 2^32 / STEP_TICK_HZ and accel is added once per tick.
+struct StepAxis {
+    uint32_t stepMask;
+    uint32_t dirMask;
+
+    volatile int32_t position;   // Steps actually emitted
+    volatile int32_t target;     // Absolute target position
+    volatile bool stopRequested;
+
+    uint32_t rate;               // Current speed (Q32 steps per tick)
+    uint32_t maxRate;            // Speed limit (Q32 steps per tick)
+    uint32_t accelRate;          // Speed change per tick
+    uint32_t phase;
+    int8_t dir;                  // Direction of motion, +1 / -1
+    int8_t velocityDir;          // Coordinated mode: direction the trajectory asks for
+    bool pulseHigh;              // STEP pin is high and must be cleared next tick
+};
+
+static StepAxis axes[STEP_AXIS_COUNT];
+static Trajectory trajectory;
+static volatile bool coordinated = false; // Axes follow the trajectory instead of their own profiles
+static uint8_t trajectoryDivider = 0;
+static hw_timer_t* stepTimer = nullptr;
+static portMUX_TYPE stepMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Helper function prototypes (private)
+static uint32_t toRate(uint32_t stepsPerSecond);
+static uint32_t toAccelRate(uint32_t stepsPerSecond2);
+static void IRAM_ATTR updateAxis(StepAxis& ax);
+static void IRAM_ATTR updateTrajectory();
+static void IRAM_ATTR stepAtRate(StepAxis& ax);
+static void IRAM_ATTR onStepTick();
+
+//-------------------------
+// Public Functions
+//-------------------------
+// Limits set with stepEngineSetLimits() before this call are kept
+void initStepEngine(const uint8_t stepPins[STEP_AXIS_COUNT], const uint8_t dirPins[STEP_AXIS_COUNT]) {
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        // Direct register writes in the ISR need pins below 32
+        pinMode(stepPins[i], OUTPUT);
+        pinMode(dirPins[i], OUTPUT);
+        digitalWrite(stepPins[i], LOW);
+        digitalWrite(dirPins[i], HIGH);
+
+        StepAxis& ax = axes[i];
+        ax.stepMask = 1UL << stepPins[i];
+        ax.dirMask = 1UL << dirPins[i];
+        ax.position = 0;
+        ax.target = 0;
+        ax.stopRequested = false;
+        ax.rate = 0;
+        ax.phase = 0;
+        ax.dir = 1; // Matches the DIR level set above
+        ax.velocityDir = 1;
+        ax.pulseHigh = false;
+    }
+
+    // 80 MHz APB / 80 = 1 MHz timer clock
+    stepTimer = timerBegin(0, 80, true);
+    timerAttachInterrupt(stepTimer, &onStepTick, true);
+    timerAlarmWrite(stepTimer, 1000000 / STEP_TICK_HZ, true);
+    timerAlarmEnable(stepTimer);
+}
+
+void stepEngineSetLimits(uint8_t axis, uint32_t maxSpeed, uint32_t accel) {
+    if (axis >= STEP_AXIS_COUNT) return;
+
+    uint32_t maxRate = toRate(maxSpeed);
+    uint32_t accelRate = toAccelRate(accel);
+
+    portENTER_CRITICAL(&stepMux);
+    axes[axis].maxRate = maxRate;
+    axes[axis].accelRate = accelRate;
+    portEXIT_CRITICAL(&stepMux);
+}
+
+void stepEngineMove(uint8_t axis, int32_t relative) {
+    if (axis >= STEP_AXIS_COUNT) return;
+
+    portENTER_CRITICAL(&stepMux);
+    coordinated = false; // Back to per-axis profiles, they pick up from the current rates
+    axes[axis].target = axes[axis].position + relative;
+    axes[axis].stopRequested = false;
+    portEXIT_CRITICAL(&stepMux);
+}
+
+void stepEngineSetTrajectoryLimits(uint32_t maxSpeed, uint32_t accel, uint32_t jerk) {
+    maxSpeed = min<uint32_t>(maxSpeed, STEP_TICK_HZ / 2);
+
+    portENTER_CRITICAL(&stepMux);
+    trajectoryInit(&trajectory, maxSpeed, accel, jerk);
+    portEXIT_CRITICAL(&stepMux);
+}
+
+void stepEngineMoveCoordinated(const int32_t relative[STEP_AXIS_COUNT]) {
+    int32_t position[STEP_AXIS_COUNT];
+
+    portENTER_CRITICAL(&stepMux);
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        StepAxis& ax = axes[i];
+        position[i] = ax.position;
+        if (!coordinated) {
+            // Coming from per-axis profiles: blend from the speeds they reached
+            int32_t speed = (int32_t)(((uint64_t)ax.rate * STEP_TICK_HZ) >> (32 - TRAJ_Q));
+            trajectory.velocity[i] = ax.dir * speed;
+        }
+    }
+    trajectoryMove(&trajectory, position, relative);
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        axes[i].target = trajectory.target[i];
+        axes[i].stopRequested = false;
+    }
+    coordinated = true;
+    portEXIT_CRITICAL(&stepMux);
+}
+
+void stepEngineStopCoordinated() {
+    int32_t position[STEP_AXIS_COUNT];
+
+    portENTER_CRITICAL(&stepMux);
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) position[i] = axes[i].position;
+    if (coordinated) {
+        trajectoryStop(&trajectory, position);
+        for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) axes[i].target = trajectory.target[i];
+    } else {
+        for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) axes[i].stopRequested = true;
+    }
+    portEXIT_CRITICAL(&stepMux);
+}
+
+void stepEngineStop(uint8_t axis) {
+    if (axis >= STEP_AXIS_COUNT) return;
+    axes[axis].stopRequested = true; // Handled in the ISR, which knows the current speed
+}
+
+int32_t stepEnginePosition(uint8_t axis) {
+    if (axis >= STEP_AXIS_COUNT) return 0;
+    return axes[axis].position;
+}
+
+int32_t stepEngineDistanceToGo(uint8_t axis) {
+    if (axis >= STEP_AXIS_COUNT) return 0;
+
+    portENTER_CRITICAL(&stepMux);
+    int32_t togo = axes[axis].target - axes[axis].position;
+    portEXIT_CRITICAL(&stepMux);
+    return togo;
+}
+
+//-------------------------
+// Private Functions
+//-------------------------
+static uint32_t toRate(uint32_t stepsPerSecond) {
+    // One step needs a high and a low tick
+    if (stepsPerSecond > STEP_TICK_HZ / 2) stepsPerSecond = STEP_TICK_HZ / 2;
+    return (uint32_t)(((uint64_t)stepsPerSecond << 32) / STEP_TICK_HZ);
+}
+
+static uint32_t toAccelRate(uint32_t stepsPerSecond2) {
+    uint32_t rate = (uint32_t)(((uint64_t)stepsPerSecond2 << 32) / ((uint64_t)STEP_TICK_HZ * STEP_TICK_HZ));
+    return rate ? rate : 1;
+}
+
+// Stopping distance from the current rate is rate^2 / (2 * accelRate * 2^32) steps.
+// Compared without division: (rate >> 16)^2 >= 2 * dist * accelRate
+static inline bool IRAM_ATTR mustDecelerate(const StepAxis& ax, uint32_t dist) {
+    uint64_t r = ax.rate >> 16;
+    return r * r >= 2ULL * dist * ax.accelRate;
+}
+
+static void IRAM_ATTR updateAxis(StepAxis& ax) {
+    // Finish the pulse started on the previous tick
+    if (ax.pulseHigh) {
+        REG_WRITE(GPIO_OUT_W1TC_REG, ax.stepMask);
+        ax.pulseHigh = false;
+    }
+
+    if (ax.stopRequested) {
+        // Retarget to the closest point we can stop at
+        uint64_t r = ax.rate >> 16;
+        int32_t stopSteps = ax.accelRate ? (int32_t)(r * r / (2ULL * ax.accelRate)) : 0;
+        ax.target = ax.position + ax.dir * stopSteps;
+        ax.stopRequested = false;
+    }
+
+    int32_t togo = ax.target - ax.position;
+
+    if (ax.rate == 0) {
+        if (togo == 0) return; // At rest on target
+
+        int8_t newDir = (togo > 0) ? 1 : -1;
+        if (newDir != ax.dir) {
+            // Change DIR while stopped, first step goes out next tick (setup time)
+            REG_WRITE(newDir > 0 ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, ax.dirMask);
+            ax.dir = newDir;
+            ax.phase = 0;
+            return;
+        }
+    }
+
+    bool sameDir = (togo > 0 && ax.dir > 0) || (togo < 0 && ax.dir < 0);
+    uint32_t dist = sameDir ? (uint32_t)abs(togo) : 0;
+
+    if (togo == 0 && !mustDecelerate(ax, 1)) {
+        // Arrived, the profile brought us in at near-zero speed
+        ax.rate = 0;
+        ax.phase = 0;
+        return;
+    }
+    // Retargeted onto the current position at speed: decelerate past it and come back
+
+    // Trapezoidal profile: decelerate if we would overshoot or are heading the wrong way
+    if (!sameDir || mustDecelerate(ax, dist) || ax.rate > ax.maxRate) {
+        ax.rate = (ax.rate > ax.accelRate) ? ax.rate - ax.accelRate : 0;
+    } else if (ax.rate < ax.maxRate) {
+        uint32_t next = ax.rate + ax.accelRate;
+        ax.rate = (next > ax.maxRate) ? ax.maxRate : next;
+    }
+
+    // Phase accumulator wraps once per step
+    uint32_t prev = ax.phase;
+    ax.phase += ax.rate;
+    if (ax.phase < prev) {
+        REG_WRITE(GPIO_OUT_W1TS_REG, ax.stepMask);
+        ax.pulseHigh = true;
+        ax.position += ax.dir;
+    }
+}
+
+// Coordinated mode, every TRAJ_TICK_DIVIDER ticks: new wheel rates from the trajectory
+static void IRAM_ATTR updateTrajectory() {
+    int32_t position[STEP_AXIS_COUNT];
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) position[i] = axes[i].position;
+
+    trajectoryUpdate(&trajectory, position);
+
+    for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+        int32_t v = trajectory.velocity[i];
+        uint32_t speed = (uint32_t)abs(v);
+        axes[i].velocityDir = (v < 0) ? -1 : 1;
+        axes[i].rate = (uint32_t)min<uint64_t>(((uint64_t)speed << (32 - TRAJ_Q)) / STEP_TICK_HZ, 0x7FFFFFFF);
+    }
+}
+
+// Coordinated mode: step at the rate the trajectory set. It owns the
+// targets too and slows each axis down before reaching its own.
+static void IRAM_ATTR stepAtRate(StepAxis& ax) {
+    if (ax.pulseHigh) {
+        REG_WRITE(GPIO_OUT_W1TC_REG, ax.stepMask);
+        ax.pulseHigh = false;
+    }
+    if (ax.rate == 0) return;
+
+    if (ax.velocityDir != ax.dir) {
+        // DIR changes on its own tick, first step goes out on the next (setup time)
+        REG_WRITE(ax.velocityDir > 0 ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, ax.dirMask);
+        ax.dir = ax.velocityDir;
+        ax.phase = 0;
+        return;
+    }
+
+    uint32_t prev = ax.phase;
+    ax.phase += ax.rate;
+    if (ax.phase < prev) {
+        REG_WRITE(GPIO_OUT_W1TS_REG, ax.stepMask);
+        ax.pulseHigh = true;
+        ax.position += ax.dir;
+    }
+}
+
+static void IRAM_ATTR onStepTick() {
+    portENTER_CRITICAL_ISR(&stepMux);
+    uint32_t start = cycleCount();
+    if (coordinated) {
+        if (++trajectoryDivider >= TRAJ_TICK_DIVIDER) {
+            trajectoryDivider = 0;
+            updateTrajectory();
+        }
+        for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+            stepAtRate(axes[i]);
+        }
+    } else {
+        for (uint8_t i = 0; i < STEP_AXIS_COUNT; i++) {
+            updateAxis(axes[i]);
+        }
+    }
+    latencyRecord(PROBE_STEP_ISR, cycleCount() - start);
+    portEXIT_CRITICAL_ISR(&stepMux);
+}
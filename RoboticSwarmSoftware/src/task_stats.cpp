@@ -0,0 +1,45 @@
+#include "task_stats.hpp"
+
+LatencyHistogram latencyHistograms[PROBE_COUNT];
+
+static const char* const PROBE_NAMES[PROBE_COUNT] = {
+    "motor_period",
+    "motor_planner",
+    "motor_snapshot",
+    "step_isr",
+    "tof_frame",
+    "ir_loop",
+    "net_loop",
+};
+
+struct TrackedTask {
+    TaskHandle_t handle;
+    const char* name;
+    uint32_t stackBytes;
+};
+
+static TrackedTask trackedTasks[TASK_STATS_MAX_TASKS];
+static uint8_t trackedCount = 0;
+
+const char* latencyProbeName(LatencyProbe probe) {
+    return (probe < PROBE_COUNT) ? PROBE_NAMES[probe] : "unknown";
+}
+
+void taskStatsRegister(TaskHandle_t task, const char* name, uint32_t stackBytes) {
+    if (!task || trackedCount >= TASK_STATS_MAX_TASKS) return;
+    trackedTasks[trackedCount].handle = task;
+    trackedTasks[trackedCount].name = name;
+    trackedTasks[trackedCount].stackBytes = stackBytes;
+    trackedCount++;
+}
+
+uint8_t taskStatsTaskCount() {
+    return trackedCount;
+}
+
+void taskStatsGetTask(uint8_t index, const char** name, uint32_t* stackBytes, uint32_t* minFreeBytes) {
+    const TrackedTask& t = trackedTasks[index];
+    *name = t.name;
+    *stackBytes = t.stackBytes;
+    *minFreeBytes = uxTaskGetStackHighWaterMark(t.handle); // ESP-IDF reports bytes, not words
+}
@@ -0,0 +1,31 @@
+#include "telemetry_frame.hpp"
+
+void buildTelemetryFrame(TelemetryFrame* frame, const State& state, uint8_t robotId, uint32_t seq,
+                         uint32_t timeMs, uint32_t plannerRuns, uint32_t plannerSaved) {
+    frame->version = TELEMETRY_VERSION;
+    frame->robotId = robotId;
+    frame->mode = (uint8_t)state.mode;
+    frame->tofValidMask = state.tof_validMask;
+    frame->seq = seq;
+    frame->timeMs = timeMs;
+    frame->tofFrameSeq = state.tof_frameSeq;
+    frame->irCycleSeq = state.ir_cycleSeq;
+    frame->plannerRuns = plannerRuns;
+    frame->plannerSaved = plannerSaved;
+
+    frame->neighborMaxDist = state.neighbor_maxDist;
+    frame->idleThresh = state.idle_thresh;
+    frame->lineNodeDist = state.line_nodeDist;
+    frame->lineAlignTol = state.line_alignTol;
+    frame->polygonRadius = state.polygon_radius;
+    frame->polygonAlignTol = state.polygon_alignTol;
+    frame->polygonSides = state.polygon_sides;
+    frame->reserved = 0;
+
+    for (int i = 0; i < 6; i++) {
+        frame->distances[i] = (state.distances[i] > 0xFFFF) ? 0xFFFF : (uint16_t)state.distances[i];
+        int16_t id = state.neighbor_ids[i];
+        frame->neighborIds[i] = (id >= 0 && id < TELEMETRY_NO_NEIGHBOR) ? (uint8_t)id : TELEMETRY_NO_NEIGHBOR;
+        frame->irQuality[i] = state.ir_quality[i];
+    }
+}
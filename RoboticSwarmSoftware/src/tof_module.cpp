@@ -1,37 +1,206 @@
 #include "tof_module.hpp"
 #include "globals.hpp"
+#include "motor_module.hpp"
+#include "flight_recorder.hpp"
+#include "task_stats.hpp"
+#include "tof_profiles.hpp"
 #include <VL53L0X.h>
 #include <Wire.h>
 
 #define TCA_ADDR 0x70         // Default address of TCA9548A
 #define SENSOR_COUNT 6
-#define SENSOR_UPDATE_MS 5    // Update interval per sensor
+#define TOF_POLL_MS 1         // Delay between data-ready sweeps over the mux
+#define TOF_PROFILE_DWELL_MS 1000 // Auto profile must want the same profile this long before switching
+#define TOF_RATE_WINDOW_MS 1000   // Sample rate reported over this window
 
 VL53L0X sensor[SENSOR_COUNT];
 bool sensorInitialized[SENSOR_COUNT] = {false};
 
+static int8_t selectedChannel = -1; // Last channel routed through the TCA, -1 = none
+static TofProfile activeProfile = TOF_PROFILE_DEFAULT;
+static uint32_t frameTimeoutMs = 66; // Publish a partial frame if a sensor stalls, two measurements
+
 //-----------------------------------------
 // Helper Functions
 void tcaSelect(uint8_t channel) {
     if (channel > 7) return;
+    if (channel == selectedChannel) return; // Mux already routed, skip the I2C write
 
     Wire.beginTransmission(TCA_ADDR);
     Wire.write(1 << channel);
     Wire.endTransmission();
+    selectedChannel = channel;
 }
 
 void tcaDeselectAll() {
     Wire.beginTransmission(TCA_ADDR);
     Wire.write(0);
     Wire.endTransmission();
+    selectedChannel = -1;
 }
 
-int readDistance(uint8_t channel) {
-    if (channel >= SENSOR_COUNT) return -1; // Invalid Channel Error
-    if (!sensorInitialized[channel]) return -2; // Sensor not initialized
+// Non-blocking replacement for readRangeContinuousMillimeters():
+// checks the data-ready bit once and only reads/clears the result if a
+// measurement has finished. Returns false if the sensor is still ranging.
+bool pollDistance(uint8_t channel, uint16_t* distance) {
+    if (channel >= SENSOR_COUNT) return false;
+    if (!sensorInitialized[channel]) return false;
 
     tcaSelect(channel);
-    return sensor[channel].readRangeContinuousMillimeters();
+    if ((sensor[channel].readReg(VL53L0X::RESULT_INTERRUPT_STATUS) & 0x07) == 0) {
+        return false; // Measurement still in progress
+    }
+
+    // Same register sequence the library uses once the interrupt bit is set
+    *distance = sensor[channel].readReg16Bit(VL53L0X::RESULT_RANGE_STATUS + 10);
+    sensor[channel].writeReg(VL53L0X::SYSTEM_INTERRUPT_CLEAR, 0x01);
+    return true;
+}
+
+//----------------------------------------
+// Range Filter (allocation-free, one per channel)
+static RangeFilter filters[SENSOR_COUNT];
+
+void resetRangeFilter(RangeFilter* f) {
+    memset(f, 0, sizeof(*f));
+}
+
+static uint16_t medianOfWindow(const RangeFilter* f) {
+    uint16_t sorted[TOF_MEDIAN_N];
+    uint8_t n = f->count;
+
+    // Insertion sort, N is tiny
+    for (uint8_t i = 0; i < n; i++) {
+        uint16_t v = f->window[i];
+        int8_t j = i - 1;
+        while (j >= 0 && sorted[j] > v) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    return sorted[n / 2];
+}
+
+void updateRangeFilter(RangeFilter* f, uint16_t raw) {
+    // Timeouts (65535), out-of-range codes (8190/8191) and zero are not ranges
+    if (raw == 0 || raw > TOF_MAX_VALID_MM) {
+        missRangeFilter(f);
+        return;
+    }
+    f->misses = 0;
+
+    f->window[f->head] = raw;
+    f->head = (f->head + 1) % TOF_MEDIAN_N;
+    if (f->count < TOF_MEDIAN_N) f->count++;
+
+    int32_t measured = (int32_t)medianOfWindow(f) << 4;
+
+    if (!f->tracking) {
+        // Wait for a majority of the window before trusting the median
+        if (f->count < (TOF_MEDIAN_N + 1) / 2) return;
+        f->x = measured;
+        f->v = 0;
+        f->gated = 0;
+        f->tracking = true;
+        return;
+    }
+
+    int32_t predicted = f->x + f->v;
+    int32_t residual = measured - predicted;
+
+    if (abs(residual) > (TOF_GATE_MM << 4)) {
+        // Outlier: coast on the prediction, unless the jump persists
+        if (++f->gated >= TOF_MAX_GATED) {
+            f->x = measured;
+            f->v = 0;
+            f->gated = 0;
+        } else {
+            f->x = predicted;
+        }
+        return;
+    }
+
+    // Alpha = 1/2, beta = 1/8
+    f->gated = 0;
+    f->x = predicted + residual / 2;
+    f->v += residual / 8;
+}
+
+void missRangeFilter(RangeFilter* f) {
+    if (++f->misses >= TOF_MAX_MISSES) {
+        resetRangeFilter(f); // Lost the target, drop history
+        return;
+    }
+    f->x += f->v; // Coast
+}
+
+uint16_t rangeFilterOutput(const RangeFilter* f) {
+    if (!f->tracking) return TOF_NO_TARGET_MM;
+
+    int32_t mm = (f->x + 8) >> 4;
+    if (mm < 0) mm = 0;
+    if (mm > TOF_MAX_VALID_MM) mm = TOF_MAX_VALID_MM;
+    return (uint16_t)mm;
+}
+
+uint8_t closeRangeFrame(RangeFilter* filters, uint8_t freshMask, uint8_t expectedMask, uint32_t* distances) {
+    uint8_t validMask = 0;
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        // Stalled sensors count as a miss and eventually go invalid
+        if ((expectedMask & (1 << i)) && !(freshMask & (1 << i))) {
+            missRangeFilter(&filters[i]);
+        }
+        distances[i] = rangeFilterOutput(&filters[i]);
+        if (filters[i].tracking) validMask |= (1 << i);
+    }
+    return validMask;
+}
+
+//----------------------------------------
+// Ranging Profiles
+
+// Stops, reprograms and restarts every sensor. Changing a VCSEL period
+// re-runs the sensor's phase calibration, so this takes a few ms per sensor.
+static void applyProfile(TofProfile profile) {
+    const TofProfileSettings& s = TOF_PROFILES[profile];
+
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        if (!sensorInitialized[i]) continue;
+        tcaSelect(i);
+
+        sensor[i].stopContinuous();
+        bool ok = sensor[i].setSignalRateLimit(s.signalRateLimit);
+        ok &= sensor[i].setVcselPulsePeriod(VL53L0X::VcselPeriodPreRange, s.preRangeVcsel);
+        ok &= sensor[i].setVcselPulsePeriod(VL53L0X::VcselPeriodFinalRange, s.finalRangeVcsel);
+        ok &= sensor[i].setMeasurementTimingBudget(s.timingBudgetUs); // Last, the VCSEL periods change it
+        sensor[i].startContinuous(s.periodMs);
+
+        if (!ok) {
+            Serial.printf("ToF profile %s rejected on channel %u\n", s.name, i);
+        }
+    }
+
+    activeProfile = profile;
+    uint32_t measurementMs = max<uint32_t>(s.periodMs, (s.timingBudgetUs + 999) / 1000);
+    frameTimeoutMs = 2 * measurementMs;
+}
+
+// What the requested profile means right now. explicitRequest is set when it
+// was asked for by name rather than picked by auto.
+static TofProfile wantedProfile(bool* explicitRequest) {
+    static Config cfg = Config(); // Keeps the last good read if the writer is mid-update
+    configLock.read(cfg);
+
+    *explicitRequest = cfg.tof_profile != TOF_PROFILE_AUTO && cfg.tof_profile < TOF_PROFILE_COUNT;
+    if (*explicitRequest) return (TofProfile)cfg.tof_profile;
+
+    switch (getFormationRole()) {
+        case ROLE_SEARCHING: return TOF_PROFILE_LONG_RANGE;
+        case ROLE_MOVING:
+        case ROLE_IN_POSITION: return TOF_PROFILE_HIGH_SPEED;
+        default: return TOF_PROFILE_DEFAULT;
+    }
 }
 
 //----------------------------------------
@@ -46,30 +215,96 @@ void initAllToFSensors() {
 
         if (sensor[i].init()) { 
             sensor[i].setTimeout(500);
-            sensor[i].startContinuous(20);
             sensorInitialized[i] = true;
         } else {
             Serial.print("ToF sensor init failed on channel ");
             Serial.println(i);
         }
     }
+
+    applyProfile(TOF_PROFILE_DEFAULT);
 }
 
+// Sweeps all six mux channels, collecting only the sensors that have a
+// finished measurement, and publishes one complete 6-direction frame as soon
+// as every initialized sensor has reported (or the frame timeout expires).
 void TOFsensorTask(void* parameter) {
-    uint8_t currentSensor = 0;
+    SensorFrame published = {};  // Last frame handed to the readers
+    uint8_t freshMask = 0;       // Channels updated since the last published frame
+    uint8_t expectedMask = 0;    // Channels that should contribute to every frame
+
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        resetRangeFilter(&filters[i]);
+        published.distances[i] = TOF_NO_TARGET_MM;
+        if (sensorInitialized[i]) expectedMask |= (1 << i);
+    }
+
+    TickType_t frameStart = xTaskGetTickCount();
+    uint32_t frameStartCycles = cycleCount();
+
+    TofProfile pendingProfile = activeProfile;
+    TickType_t pendingSince = frameStart;
+    TickType_t rateStart = frameStart;
+    uint32_t rateFrames = 0;
+    published.tof_activeProfile = activeProfile;
 
     while (true) {
-        if (sensorInitialized[currentSensor]) {
-            int distance = readDistance(currentSensor);
+        // Explicit requests switch at once, auto ones once they have settled,
+        // so a planner flicking between search and move doesn't thrash the sensors
+        bool explicitRequest;
+        TofProfile wanted = wantedProfile(&explicitRequest);
+        if (wanted != pendingProfile) {
+            pendingProfile = wanted;
+            pendingSince = xTaskGetTickCount();
+        }
+        bool settled = (xTaskGetTickCount() - pendingSince) >= pdMS_TO_TICKS(TOF_PROFILE_DWELL_MS);
+        if (pendingProfile != activeProfile && (settled || explicitRequest)) {
+            applyProfile(pendingProfile);
+            published.tof_activeProfile = activeProfile;
+            freshMask = 0; // Measurements in flight were taken with the old settings
+            frameStart = xTaskGetTickCount();
+            frameStartCycles = cycleCount();
+        }
+
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+            if (freshMask & (1 << i)) continue; // Already have this direction
+
+            uint16_t distance;
+            if (pollDistance(i, &distance)) {
+                updateRangeFilter(&filters[i], distance);
+                freshMask |= (1 << i);
+            }
+        }
+
+        bool complete = (freshMask & expectedMask) == expectedMask;
+        bool timedOut = (xTaskGetTickCount() - frameStart) >= pdMS_TO_TICKS(frameTimeoutMs);
 
-            // Update state with mutex protection
-            if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-                state.distances[currentSensor] = distance;
-                xSemaphoreGive(stateMutex);
+        // A timeout publishes even if nothing arrived: with the mux or the bus
+        // hung every channel misses, goes invalid, and the planner stops
+        // steering on the last good ranges
+        if (timedOut || (complete && freshMask != 0)) {
+            uint8_t validMask = closeRangeFrame(filters, freshMask, expectedMask, published.distances);
+            published.tof_validMask = validMask;
+            published.tof_frameSeq++;
+
+            // Effective sample rate, what the profile actually delivers
+            rateFrames++;
+            TickType_t rateElapsed = xTaskGetTickCount() - rateStart;
+            if (rateElapsed >= pdMS_TO_TICKS(TOF_RATE_WINDOW_MS)) {
+                published.tof_rateX10 = (uint16_t)(rateFrames * 10000UL / (rateElapsed * portTICK_PERIOD_MS));
+                rateFrames = 0;
+                rateStart = xTaskGetTickCount();
             }
+            sensorLock.write(published); // Never blocks, no frame is dropped
+            notifyPlanner(PLANNER_EVENT_SENSOR);
+            recordTofFrame(published.distances, validMask, published.tof_frameSeq);
+            latencyRecord(PROBE_TOF_FRAME, cycleCount() - frameStartCycles);
+
+            freshMask = 0;
+            frameStart = xTaskGetTickCount();
+            frameStartCycles = cycleCount();
         }
 
-        currentSensor = (currentSensor + 1) % SENSOR_COUNT;
-        vTaskDelay(pdMS_TO_TICKS(SENSOR_UPDATE_MS));
+        vTaskDelay(pdMS_TO_TICKS(TOF_POLL_MS));
     }
 }
@@ -0,0 +1,160 @@
+#include "trajectory.hpp"
+
+static inline int32_t clampStep(int32_t value, int32_t limit) {
+    return (value > limit) ? limit : (value < -limit) ? -limit : value;
+}
+
+// Same, for products that only fit in 64 bits: a long move's tracking error
+// or distance to go, scaled to Q8 steps/s, passes INT32_MAX past ~8000 steps
+static inline int32_t clampStep64(int64_t value, int32_t limit) {
+    return (int32_t)((value > limit) ? limit : (value < -limit) ? -limit : value);
+}
+
+void trajectoryInit(Trajectory* t, uint32_t maxSpeed, uint32_t accel, uint32_t jerk) {
+    memset(t, 0, sizeof(*t));
+    t->maxSpeed = (int32_t)(maxSpeed << TRAJ_Q);
+    t->accel = (int32_t)(max<uint32_t>(accel, 1) << TRAJ_Q);
+    t->jerk = (int32_t)(max<uint32_t>(jerk, TRAJ_UPDATE_HZ) << TRAJ_Q);
+}
+
+// Distance (Q8 steps) to come to rest from speed v with acceleration a at
+// the jerk limit. From a <= 0 it is v^2/2A + v(A+a)/2J. Still accelerating,
+// a has to ramp to zero first: a/J seconds covering va/J + a^3/3J^2 and
+// gaining a^2/2J of speed. 1/16 margin, braking early only costs a short crawl.
+static int64_t IRAM_ATTR stoppingDistance(const Trajectory* t, int64_t v, int64_t a) {
+    int64_t j = t->jerk;
+    int64_t ramp = 0;
+    if (a > 0) {
+        ramp = v * a / j + (a * a / j) * a / (3 * j);
+        v += a * a / (2 * j);
+        a = 0;
+    }
+    int64_t d = ramp + v * v / (2 * t->accel) + v * (t->accel + a) / (2 * j);
+    return d + d / 16;
+}
+
+void trajectoryMove(Trajectory* t, const int32_t position[TRAJ_AXES], const int32_t relative[TRAJ_AXES]) {
+    uint8_t dominant = 0;
+    for (uint8_t i = 1; i < TRAJ_AXES; i++) {
+        if (abs(relative[i]) > abs(relative[dominant])) dominant = i;
+    }
+    int32_t length = abs(relative[dominant]);
+    if (length == 0) {
+        trajectoryHold(t, position);
+        return;
+    }
+
+    int32_t unit[TRAJ_AXES];
+    int64_t unitNorm = 0;
+    int64_t along = 0;
+    for (uint8_t i = 0; i < TRAJ_AXES; i++) {
+        unit[i] = (int32_t)(((int64_t)relative[i] << TRAJ_UNIT_Q) / length);
+        unitNorm += (int64_t)unit[i] * unit[i];
+        along += (int64_t)t->velocity[i] * unit[i];
+    }
+
+    // Blend: keep the part of the current wheel motion that points the new way.
+    // Straight on keeps speed and acceleration; a reversal starts from rest.
+    int64_t speed = max<int64_t>(along / (unitNorm >> TRAJ_UNIT_Q), 0);
+    int32_t keep = (t->speed > 0) ? (int32_t)min<int64_t>((speed << TRAJ_UNIT_Q) / t->speed, 1 << TRAJ_UNIT_Q) : 0;
+    t->accelNow = (int32_t)((int64_t)t->accelNow * keep >> TRAJ_UNIT_Q);
+    t->speed = (int32_t)min<int64_t>(speed, t->maxSpeed);
+
+    for (uint8_t i = 0; i < TRAJ_AXES; i++) {
+        t->start[i] = position[i];
+        t->delta[i] = relative[i];
+        t->target[i] = position[i] + relative[i];
+        t->unit[i] = unit[i];
+    }
+    t->dominant = dominant;
+    t->length = length;
+    t->active = true;
+}
+
+void trajectoryHold(Trajectory* t, const int32_t position[TRAJ_AXES]) {
+    for (uint8_t i = 0; i < TRAJ_AXES; i++) {
+        t->start[i] = t->target[i] = position[i];
+        t->delta[i] = 0;
+    }
+    t->length = 0;
+    t->speed = 0;
+    t->accelNow = 0;
+    t->active = true; // Wheels still turning brake at the slew limit and come back
+}
+
+void trajectoryStop(Trajectory* t, const int32_t position[TRAJ_AXES]) {
+    if (!t->active || t->speed == 0) {
+        trajectoryHold(t, position);
+        return;
+    }
+
+    // Shorten the segment to the stopping distance, the profile brakes at once
+    int32_t stop = (int32_t)(stoppingDistance(t, t->speed, min<int32_t>(t->accelNow, 0)) >> TRAJ_Q) + 1;
+    int32_t relative[TRAJ_AXES];
+    for (uint8_t i = 0; i < TRAJ_AXES; i++) {
+        relative[i] = (int32_t)((int64_t)stop * t->unit[i] >> TRAJ_UNIT_Q);
+    }
+    trajectoryMove(t, position, relative);
+}
+
+bool IRAM_ATTR trajectoryUpdate(Trajectory* t, const int32_t position[TRAJ_AXES]) {
+    if (!t->active) return false;
+
+    // Signed, so a wheel still unwinding the previous segment doesn't count as progress
+    int32_t moved = position[t->dominant] - t->start[t->dominant];
+    int32_t progress = constrain((t->delta[t->dominant] > 0) ? moved : -moved, 0, t->length);
+    int32_t remaining = t->length - progress;
+
+    //-------- S-curve along the dominant axis --------
+    if (remaining == 0) {
+        t->speed = 0;
+        t->accelNow = 0;
+    } else {
+        int32_t goal;
+        if (stoppingDistance(t, t->speed, t->accelNow) + t->speed / TRAJ_UPDATE_HZ >= ((int64_t)remaining << TRAJ_Q)) {
+            goal = -t->accel;  // Brake
+        } else if (t->speed + (t->accelNow > 0 ? (int64_t)t->accelNow * t->accelNow / (2 * (int64_t)t->jerk) : 0) >= t->maxSpeed) {
+            goal = 0;          // Ease into cruise without overshooting the speed limit
+        } else {
+            goal = t->accel;
+        }
+
+        t->accelNow += clampStep(goal - t->accelNow, t->jerk / TRAJ_UPDATE_HZ);
+        t->speed += t->accelNow / TRAJ_UPDATE_HZ;
+
+        if (t->speed >= t->maxSpeed) {
+            t->speed = t->maxSpeed;
+            if (t->accelNow > 0) t->accelNow = 0;
+        }
+        if (t->speed < (TRAJ_CREEP_SPEED << TRAJ_Q)) {
+            // Braked a little early, crawl the last steps in
+            t->speed = TRAJ_CREEP_SPEED << TRAJ_Q;
+            if (t->accelNow < 0) t->accelNow = 0;
+        }
+    }
+
+    //-------- Wheels follow the straight line --------
+    bool moving = false;
+    int32_t slew = t->accel / TRAJ_UPDATE_HZ;
+    for (uint8_t i = 0; i < TRAJ_AXES; i++) {
+        int32_t togo = t->target[i] - position[i];
+        int32_t desired = 0;
+        if (togo != 0) {
+            int32_t expected = remaining ? t->start[i] + (int32_t)((int64_t)t->delta[i] * progress / t->length) : t->target[i];
+            int64_t along = (int64_t)t->speed * t->unit[i] >> TRAJ_UNIT_Q;
+            int64_t track = (int64_t)(expected - position[i]) * (TRAJ_TRACK_GAIN << TRAJ_Q);
+            desired = clampStep64(along + track, t->maxSpeed);
+        }
+
+        int32_t v = t->velocity[i] + clampStep(desired - t->velocity[i], slew);
+        // Approaching the target: no faster than reaching it within one update,
+        // so it is never overshot by more than a step
+        if ((v > 0) == (togo > 0)) v = clampStep(v, clampStep64((int64_t)abs(togo) * (TRAJ_UPDATE_HZ << TRAJ_Q), t->maxSpeed));
+        if (togo == 0 && desired == 0 && abs(v) <= slew) v = 0;
+        t->velocity[i] = v;
+        if (togo != 0 || v != 0) moving = true;
+    }
+
+    t->active = moving;
+    return moving;
+}